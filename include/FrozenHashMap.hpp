@@ -0,0 +1,427 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "HashMap.hpp"
+
+// Number of keys the bucket count search and the seed search of FrozenHashMap may visit
+// each, and the largest number of seeds it tries.  Zero seed budget disables the seed
+// search.
+#ifndef CTM_FROZEN_HASH_MAP_BUCKET_COUNT_SEARCH_BUDGET
+#define CTM_FROZEN_HASH_MAP_BUCKET_COUNT_SEARCH_BUDGET 16777216
+#endif
+
+#ifndef CTM_FROZEN_HASH_MAP_SEED_SEARCH_BUDGET
+#define CTM_FROZEN_HASH_MAP_SEED_SEARCH_BUDGET 16777216
+#endif
+
+#ifndef CTM_FROZEN_HASH_MAP_MAX_SEED_COUNT
+#define CTM_FROZEN_HASH_MAP_MAX_SEED_COUNT 64
+#endif
+
+// Smallest number of keys per thread of a parallel build, smaller maps use fewer
+// threads.
+#ifndef CTM_FROZEN_HASH_MAP_MIN_THREAD_KEY_COUNT
+#define CTM_FROZEN_HASH_MAP_MIN_THREAD_KEY_COUNT 4096
+#endif
+
+namespace ctm {
+namespace Internal {
+// Key type a FrozenHashMap stores, string keys become views of its own characters.
+// Character pointers are strings too, their keys would otherwise be compared by address.
+template <typename TKey>
+struct FrozenKey {
+  using Type = TKey;
+};
+
+template <>
+struct FrozenKey<std::string> {
+  using Type = String;
+};
+
+template <>
+struct FrozenKey<char const*> {
+  using Type = String;
+};
+
+template <>
+struct FrozenKey<char*> {
+  using Type = String;
+};
+
+#if CTM_HAS_STRING_VIEW
+template <>
+struct FrozenKey<std::string_view> {
+  using Type = String;
+};
+#endif
+
+// `maxBucketSize` of the hashes of the runtime builder, `counts` is its scratch
+// histogram.
+template <typename TReduction>
+struct VectorBucketSizes {
+  std::size_t operator()(std::size_t bucket_count) const {
+    counts.assign(bucket_count, 0);
+    std::size_t result = 0;
+    for (auto const hash : hashes) {
+      auto const size = ++counts[TReduction::reduce(hash, bucket_count)];
+      if (size > result)
+        result = size;
+    }
+    return result;
+  }
+
+  std::vector<std::size_t> const& hashes;
+  std::vector<std::uint32_t>& counts;
+};
+
+// Result of the search for one seed, ordered by the largest bucket, then by the bucket
+// count, then by the seed index, so parallel searches pick what a serial one would.
+struct FrozenSearchResult {
+  bool operator<(FrozenSearchResult const& other) const {
+    if (maxBucketSize != other.maxBucketSize)
+      return maxBucketSize < other.maxBucketSize;
+    if (bucketCount != other.bucketCount)
+      return bucketCount < other.bucketCount;
+    return seedIndex < other.seedIndex;
+  }
+
+  std::size_t maxBucketSize;
+  std::size_t bucketCount;
+  std::size_t seedIndex;
+};
+
+// Calls `function(i)` for every `i` below `thread_count`, `function(0)` on the calling
+// thread.
+template <typename TFunction>
+void runThreads(std::size_t thread_count, TFunction const& function) {
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (std::size_t i = 1; i < thread_count; ++i)
+    threads.emplace_back(function, i);
+  function(0);
+  for (auto& thread : threads)
+    thread.join();
+}
+}
+
+// Hash map built at runtime from keys that are only known at startup.  The builder runs
+// the bucket count and seed search of `makeHashMapSpec` over the keys once, then the map
+// is immutable: pairs packed by bucket in one array, as with `CompactStorage`, and string
+// keys copied into one character buffer.  Lookups have the interface of HashMap.
+template <typename TKey,
+          typename TValue,
+          typename TReduction = ModuloReduction,
+          typename TBytesHash = BytesHash>
+class FrozenHashMap {
+public:
+  using KeyType = typename Internal::FrozenKey<TKey>::Type;
+  using ValueType = TValue;
+  using PairType = std::pair<KeyType, ValueType>;
+  using HashedKeyType = HashedKey<KeyType, Internal::KeyHash<TBytesHash>>;
+
+  FrozenHashMap(FrozenHashMap&&) = default;
+
+  FrozenHashMap& operator=(FrozenHashMap&&) = default;
+
+  // Keys point to the characters of the map, a copy would have to move them.
+  FrozenHashMap(FrozenHashMap const&) = delete;
+
+  FrozenHashMap& operator=(FrozenHashMap const&) = delete;
+
+  auto begin() const { return _pairs.begin(); }
+
+  auto end() const { return _pairs.end(); }
+
+  std::size_t bucketSize() const { return _maxBucketSize; };
+
+  std::size_t bucketCount() const { return _bucketCount; };
+
+  std::size_t size() const { return _pairs.size(); };
+
+  std::size_t seed() const { return _seed; };
+
+  template <typename U>
+  ValueType find(U const& key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? pair->second : ValueType{};
+  }
+
+  // Looks up a string key that does not have to be terminated by a null character.
+  ValueType find(char const* chars, std::size_t size) const noexcept {
+    return find(String(chars, size));
+  }
+
+  // Stored pair of a key, nullptr when the map does not have the key.
+  template <typename U>
+  PairType const* findPair(U const& key) const noexcept {
+    return findKey(Internal::LookupKey<KeyType>::make(key));
+  }
+
+  // Looks up a key hashed by the caller, the bytes of the key are not hashed again.
+  PairType const* findPair(HashedKeyType const& key) const noexcept {
+    return findHashedKey(key.key(), Internal::seedHash(key.hash(), _seed));
+  }
+
+  // Stored value of a key without a copy, nullptr when the map does not have the key.
+  template <typename U>
+  ValueType const* findPtr(U const& key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? &pair->second : nullptr;
+  }
+
+  template <typename U>
+  bool contains(U const& key) const noexcept {
+    return findPair(key) != nullptr;
+  }
+
+  // Throws std::out_of_range when the map does not have the key.
+  template <typename U>
+  ValueType const& at(U const& key) const {
+    auto const pair = findPair(key);
+    if (!pair)
+      throw std::out_of_range("ctm::FrozenHashMap::at: no such key");
+    return pair->second;
+  }
+
+  template <typename U>
+  auto operator[](U const& key) const {
+    return find(key);
+  }
+
+  // Builds a map from the pairs in `[first, last)`, repeated keys keep their first value.
+  // `thread_count` threads hash the keys and search the seeds, the result does not depend
+  // on their number.
+  template <typename TIterator>
+  static FrozenHashMap
+  make(TIterator first, TIterator last, std::size_t thread_count = 1) {
+    return make(first, last, 1.0, 0.5, thread_count);
+  }
+
+  template <typename TIterator>
+  static FrozenHashMap make(TIterator first,
+                            TIterator last,
+                            double load_factor,
+                            double min_load_factor,
+                            std::size_t thread_count = 1) {
+    FrozenHashMap map;
+    std::vector<PairType> data_pairs;
+    map.copyPairs(first, last, data_pairs);
+    map.rebaseKeys(data_pairs);
+    if (data_pairs.size() > std::numeric_limits<std::uint32_t>::max())
+      throw std::length_error("FrozenHashMap: too many keys");
+    if (thread_count > data_pairs.size() / CTM_FROZEN_HASH_MAP_MIN_THREAD_KEY_COUNT)
+      thread_count = data_pairs.size() / CTM_FROZEN_HASH_MAP_MIN_THREAD_KEY_COUNT;
+    if (thread_count == 0)
+      thread_count = 1;
+
+    std::vector<std::size_t> key_hashes(data_pairs.size());
+    auto const chunk_size = (data_pairs.size() + thread_count - 1) / thread_count;
+    Internal::runThreads(thread_count, [&](std::size_t thread_index) {
+      auto const chunk_end = (thread_index + 1) * chunk_size < data_pairs.size()
+                               ? (thread_index + 1) * chunk_size
+                               : data_pairs.size();
+      for (std::size_t i = thread_index * chunk_size; i < chunk_end; ++i)
+        key_hashes[i] = KeyHash()(data_pairs[i].first);
+    });
+    auto const element_count = removeNonuniquenesses(data_pairs, key_hashes);
+    if (element_count == 0)
+      return map;
+
+    std::size_t const first_bucket_count
+      = TReduction::bucketCount(static_cast<std::size_t>(element_count / load_factor));
+    auto const last_bucket_count
+      = static_cast<std::size_t>(element_count / min_load_factor);
+    auto const try_count
+      = CTM_FROZEN_HASH_MAP_BUCKET_COUNT_SEARCH_BUDGET / element_count + 1;
+    std::size_t const bucket_count_stride
+      = last_bucket_count > first_bucket_count
+          ? (last_bucket_count - first_bucket_count) / try_count + 1
+          : 1;
+    // Seeds get an equal share of the seed search budget.  The zero seed leaves the
+    // hashes as they are and is searched with the bucket count budget.
+    std::size_t seed_count = CTM_FROZEN_HASH_MAP_SEED_SEARCH_BUDGET / element_count;
+    if (seed_count > CTM_FROZEN_HASH_MAP_MAX_SEED_COUNT)
+      seed_count = CTM_FROZEN_HASH_MAP_MAX_SEED_COUNT;
+    std::size_t const seed_bucket_count_stride
+      = seed_count && last_bucket_count > first_bucket_count
+          ? (last_bucket_count - first_bucket_count)
+                / (CTM_FROZEN_HASH_MAP_SEED_SEARCH_BUDGET / (seed_count * element_count))
+              + 1
+          : 1;
+    // Seeds are dealt to the threads in turn, every thread keeps its best one.  A thread
+    // stops once it has a single key per bucket at the first bucket count, nothing beats
+    // that.
+    if (thread_count > seed_count + 1)
+      thread_count = seed_count + 1;
+    std::vector<Internal::FrozenSearchResult> thread_bests(
+      thread_count, {std::numeric_limits<std::size_t>::max(), first_bucket_count, 0});
+    std::vector<std::vector<std::size_t>> thread_hashes(
+      thread_count, std::vector<std::size_t>(element_count));
+    std::vector<std::vector<std::uint32_t>> thread_counts(thread_count);
+    Internal::runThreads(thread_count, [&](std::size_t thread_index) {
+      auto& best = thread_bests[thread_index];
+      auto& hashes = thread_hashes[thread_index];
+      for (std::size_t i = thread_index; i <= seed_count; i += thread_count) {
+        if (best.maxBucketSize <= 1 && best.bucketCount == first_bucket_count)
+          break;
+        auto const seed = Internal::makeSeed(i);
+        for (std::size_t j = 0; j < element_count; ++j)
+          hashes[j] = Internal::seedHash(key_hashes[j], seed);
+        Internal::FrozenSearchResult current{
+          std::numeric_limits<std::size_t>::max(), first_bucket_count, i};
+        Internal::searchBucketCount<TReduction>(
+          Internal::VectorBucketSizes<TReduction>{hashes, thread_counts[thread_index]},
+          element_count,
+          min_load_factor,
+          first_bucket_count,
+          i ? seed_bucket_count_stride : bucket_count_stride,
+          current.bucketCount,
+          current.maxBucketSize);
+        if (current < best)
+          best = current;
+      }
+    });
+    auto best = thread_bests[0];
+    for (auto const& thread_best : thread_bests) {
+      if (thread_best < best)
+        best = thread_best;
+    }
+
+    map._maxBucketSize = best.maxBucketSize;
+    map._bucketCount = best.bucketCount;
+    map._seed = Internal::makeSeed(best.seedIndex);
+    map.fillBuckets(data_pairs, key_hashes);
+    return map;
+  }
+
+private:
+  using KeyHash = Internal::KeyHash<TBytesHash>;
+
+  using IsStringKey = std::is_same<KeyType, String>;
+
+  FrozenHashMap() : _maxBucketSize(0), _bucketCount(1), _seed(0), _offsets(2, 0) {}
+
+  template <typename TIterator>
+  void copyPairs(TIterator first, TIterator last, std::vector<PairType>& data_pairs) {
+    for (auto it = first; it != last; ++it)
+      data_pairs.emplace_back(copyKey(KeyType((*it).first), IsStringKey()), (*it).second);
+  }
+
+  static KeyType copyKey(KeyType const& key, std::false_type) { return key; }
+
+  // Only appends the characters, the keys point to them once all keys are known, so the
+  // buffer does not move under the keys.
+  String copyKey(String const& key, std::true_type) {
+    _chars.insert(_chars.end(), key.chars(), key.chars() + key.size());
+    return String(nullptr, key.size());
+  }
+
+  void rebaseKeys(std::vector<PairType>& data_pairs) {
+    if (!IsStringKey::value)
+      return;
+    std::size_t offset = 0;
+    for (auto& pair : data_pairs)
+      offset += rebaseKey(pair.first, offset);
+  }
+
+  std::size_t rebaseKey(String& key, std::size_t offset) {
+    key = String(_chars.data() + offset, key.size());
+    return key.size();
+  }
+
+  template <typename U>
+  std::size_t rebaseKey(U&, std::size_t) {
+    return 0;
+  }
+
+  // Drops the repeated keys after their first occurrence, from the pairs and from their
+  // hashes.  Returns the number of unique keys.
+  static std::size_t removeNonuniquenesses(std::vector<PairType>& data_pairs,
+                                           std::vector<std::size_t>& hashes) {
+    auto const table_size = Internal::probeTableSize(data_pairs.size());
+    // Indexes of the unique keys plus one, zero is an empty slot.
+    std::vector<std::size_t> table(table_size, 0);
+    std::size_t element_count = 0;
+    for (std::size_t i = 0; i < data_pairs.size(); ++i) {
+      auto slot = internal::mixHash(hashes[i]) & (table_size - 1);
+      bool is_unique = true;
+      for (; table[slot] != 0; slot = (slot + 1) & (table_size - 1)) {
+        auto const j = table[slot] - 1;
+        if (hashes[j] == hashes[i] && data_pairs[j].first == data_pairs[i].first) {
+          is_unique = false;
+          break;
+        }
+      }
+      if (!is_unique)
+        continue;
+      if (element_count != i) {
+        data_pairs[element_count] = std::move(data_pairs[i]);
+        hashes[element_count] = hashes[i];
+      }
+      table[slot] = ++element_count;
+    }
+    data_pairs.resize(element_count);
+    hashes.resize(element_count);
+    return element_count;
+  }
+
+  void fillBuckets(std::vector<PairType>& data_pairs,
+                   std::vector<std::size_t> const& key_hashes) {
+    std::vector<std::size_t> bucket_indexes(data_pairs.size());
+    std::vector<std::size_t> hashes(data_pairs.size());
+    _offsets.assign(_bucketCount + 1, 0);
+    for (std::size_t i = 0; i < data_pairs.size(); ++i) {
+      hashes[i] = Internal::seedHash(key_hashes[i], _seed);
+      bucket_indexes[i] = TReduction::reduce(hashes[i], _bucketCount);
+      ++_offsets[bucket_indexes[i] + 1];
+    }
+    for (std::size_t i = 0; i < _bucketCount; ++i)
+      _offsets[i + 1] += _offsets[i];
+    std::vector<std::uint32_t> cursors(_offsets.begin(), _offsets.end() - 1);
+    std::vector<std::size_t> order(data_pairs.size());
+    for (std::size_t i = 0; i < data_pairs.size(); ++i)
+      order[cursors[bucket_indexes[i]]++] = i;
+    _pairs.reserve(data_pairs.size());
+    for (auto const i : order)
+      _pairs.push_back(std::move(data_pairs[i]));
+    if (Internal::HasFingerprints<KeyType>::value) {
+      _fingerprints.reserve(data_pairs.size());
+      for (auto const i : order)
+        _fingerprints.push_back(Internal::makeFingerprint(hashes[i]));
+    }
+  }
+
+  template <typename U>
+  PairType const* findKey(U const& key) const noexcept {
+    return findHashedKey(key, Internal::seedHash(KeyHash()(key), _seed));
+  }
+
+  template <typename U>
+  PairType const* findHashedKey(U const& key, std::size_t hash) const noexcept {
+    auto const index = TReduction::reduce(hash, _bucketCount);
+    auto const fingerprint = Internal::makeFingerprint(hash);
+    for (std::size_t i = _offsets[index], end = _offsets[index + 1]; i != end; ++i) {
+      if ((!Internal::HasFingerprints<KeyType>::value || _fingerprints[i] == fingerprint)
+          && _pairs[i].first == key)
+        return &_pairs[i];
+    }
+    return nullptr;
+  }
+
+  std::size_t _maxBucketSize;
+  std::size_t _bucketCount;
+  std::size_t _seed;
+  std::vector<std::uint32_t> _offsets;
+  std::vector<std::size_t> _fingerprints;
+  std::vector<PairType> _pairs;
+  std::vector<char> _chars;
+};
+}
@@ -0,0 +1,394 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "FrozenHashMap.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CTM_HAS_MMAP 1
+#endif
+
+namespace ctm {
+// Hash and bucket reduction of frozen images, fixed so that a reader finds the buckets
+// of the writer.
+using FrozenImageHash = WyBytesHash<>;
+using FrozenImageReduction = ModuloReduction;
+
+// Map a frozen image is built from.
+template <typename TValue = std::string>
+using FrozenImageBuilder
+  = FrozenHashMap<std::string, TValue, FrozenImageReduction, FrozenImageHash>;
+
+// Key and value of an element, as offsets into the characters of an image.
+struct FrozenImageEntry {
+  std::uint32_t keyOffset;
+  std::uint32_t keySize;
+  std::uint32_t valueOffset;
+  std::uint32_t valueSize;
+};
+
+// Binary image layout, in the native byte order: this header, then `bucketCount + 1`
+// uint32 bucket offsets, `elementCount` uint64 fingerprints, `elementCount` entries and
+// `charCount` characters, every section aligned to 8 bytes.
+struct FrozenImageHeader {
+  constexpr static std::uint32_t currentVersion = 1;
+  constexpr static std::uint32_t byteOrderMark = 0x01020304;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;
+  std::uint64_t wordSize;
+  std::uint64_t bucketCount;
+  std::uint64_t maxBucketSize;
+  std::uint64_t elementCount;
+  std::uint64_t seed;
+  std::uint64_t charCount;
+};
+
+namespace Internal {
+constexpr char frozenImageMagic[8] = {'c', 't', 'm', 'i', 'm', 'a', 'g', 'e'};
+
+constexpr std::size_t alignFrozenImageSection(std::size_t size) {
+  return (size + 7) & ~std::size_t(7);
+}
+}
+
+// Read-only string map over the tables of a frozen image: either the arrays of a header
+// generated by `ctmgen --header`, or a binary image in memory, e.g. an mmap-ed file.
+// Nothing is copied, lookups return views of the values in the image and an empty
+// String for missing keys.
+class FrozenImageMap {
+public:
+  using HashedKeyType = HashedKey<String, Internal::KeyHash<FrozenImageHash>>;
+
+  constexpr FrozenImageMap(std::size_t bucket_count,
+                           std::size_t max_bucket_size,
+                           std::size_t element_count,
+                           std::size_t seed,
+                           std::uint32_t const* offsets,
+                           std::uint64_t const* fingerprints,
+                           FrozenImageEntry const* entries,
+                           char const* chars)
+    : _bucketCount(bucket_count),
+      _maxBucketSize(max_bucket_size),
+      _elementCount(element_count),
+      _seed(seed),
+      _offsets(offsets),
+      _fingerprints(fingerprints),
+      _entries(entries),
+      _chars(chars) {}
+
+  // Checks the header, the size and the tables of a binary image: the bucket offsets
+  // have to be ascending up to the element count and every key and value has to lie
+  // within the characters.  Throws std::runtime_error for images of other versions or
+  // platforms and for truncated or corrupt images.
+  static FrozenImageMap fromImage(void const* data, std::size_t size) {
+    FrozenImageHeader header;
+    if (size < sizeof(header) || reinterpret_cast<std::uintptr_t>(data) % 8 != 0)
+      throw std::runtime_error("FrozenImageMap: truncated or misaligned image");
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, Internal::frozenImageMagic, sizeof(header.magic)) != 0)
+      throw std::runtime_error("FrozenImageMap: not a frozen image");
+    if (header.version != FrozenImageHeader::currentVersion)
+      throw std::runtime_error("FrozenImageMap: unsupported image version");
+    if (header.byteOrder != FrozenImageHeader::byteOrderMark
+        || header.wordSize != sizeof(std::size_t))
+      throw std::runtime_error("FrozenImageMap: image of another platform");
+    // Every section is checked against the rest of the image before the next offset is
+    // computed, so that corrupt counts cannot overflow the size arithmetic.
+    auto const bytes = static_cast<char const*>(data);
+    auto const offsets_offset = Internal::alignFrozenImageSection(sizeof(header));
+    if (header.bucketCount == 0
+        || header.bucketCount >= (size - offsets_offset) / sizeof(std::uint32_t))
+      throw std::runtime_error("FrozenImageMap: truncated image");
+    auto const fingerprints_offset = Internal::alignFrozenImageSection(
+      offsets_offset + (header.bucketCount + 1) * sizeof(std::uint32_t));
+    auto const element_size = sizeof(std::uint64_t) + sizeof(FrozenImageEntry);
+    if (size < fingerprints_offset
+        || header.elementCount > (size - fingerprints_offset) / element_size)
+      throw std::runtime_error("FrozenImageMap: truncated image");
+    auto const entries_offset
+      = fingerprints_offset + header.elementCount * sizeof(std::uint64_t);
+    auto const chars_offset
+      = entries_offset + header.elementCount * sizeof(FrozenImageEntry);
+    if (size - chars_offset < header.charCount)
+      throw std::runtime_error("FrozenImageMap: truncated image");
+    auto const offsets = reinterpret_cast<std::uint32_t const*>(bytes + offsets_offset);
+    auto const entries
+      = reinterpret_cast<FrozenImageEntry const*>(bytes + entries_offset);
+    if (offsets[0] != 0 || offsets[header.bucketCount] != header.elementCount)
+      throw std::runtime_error("FrozenImageMap: corrupt bucket offsets");
+    for (std::size_t i = 0; i != header.bucketCount; ++i) {
+      if (offsets[i] > offsets[i + 1])
+        throw std::runtime_error("FrozenImageMap: corrupt bucket offsets");
+    }
+    for (std::size_t i = 0; i != header.elementCount; ++i) {
+      auto const& entry = entries[i];
+      if (std::uint64_t(entry.keyOffset) + entry.keySize > header.charCount
+          || std::uint64_t(entry.valueOffset) + entry.valueSize > header.charCount)
+        throw std::runtime_error("FrozenImageMap: corrupt entry");
+    }
+    return FrozenImageMap(
+      header.bucketCount,
+      header.maxBucketSize,
+      header.elementCount,
+      header.seed,
+      offsets,
+      reinterpret_cast<std::uint64_t const*>(bytes + fingerprints_offset),
+      entries,
+      bytes + chars_offset);
+  }
+
+  constexpr std::size_t bucketSize() const { return _maxBucketSize; };
+
+  constexpr std::size_t bucketCount() const { return _bucketCount; };
+
+  constexpr std::size_t size() const { return _elementCount; };
+
+  constexpr std::size_t seed() const { return _seed; };
+
+  template <typename U>
+  constexpr String find(U const& key) const noexcept {
+    return findKey(Internal::LookupKey<String>::make(key));
+  }
+
+  // Looks up a string key that does not have to be terminated by a null character.
+  constexpr String find(char const* chars, std::size_t size) const noexcept {
+    return findKey(String(chars, size));
+  }
+
+  // Looks up a key hashed by the caller, the bytes of the key are not hashed again.
+  constexpr String find(HashedKeyType const& key) const noexcept {
+    return findHashedKey(key.key(), Internal::seedHash(key.hash(), _seed));
+  }
+
+  template <typename U>
+  constexpr auto operator[](U const& key) const {
+    return find(key);
+  }
+
+private:
+  constexpr String findKey(String const& key) const noexcept {
+    return findHashedKey(
+      key, Internal::seedHash(FrozenImageHash::hash(key.chars(), key.size()), _seed));
+  }
+
+  constexpr String findHashedKey(String const& key, std::size_t hash) const noexcept {
+    auto const fingerprint = Internal::makeFingerprint(hash);
+    auto const index = FrozenImageReduction::reduce(hash, _bucketCount);
+    for (std::size_t i = _offsets[index], end = _offsets[index + 1]; i != end; ++i) {
+      if (_fingerprints[i] != fingerprint)
+        continue;
+      auto const& entry = _entries[i];
+      if (String(_chars + entry.keyOffset, entry.keySize) == key)
+        return String(_chars + entry.valueOffset, entry.valueSize);
+    }
+    return String{};
+  }
+
+  std::size_t _bucketCount;
+  std::size_t _maxBucketSize;
+  std::size_t _elementCount;
+  std::size_t _seed;
+  std::uint32_t const* _offsets;
+  std::uint64_t const* _fingerprints;
+  FrozenImageEntry const* _entries;
+  char const* _chars;
+};
+
+namespace Internal {
+// Tables of a frozen image in memory, in the order of the pairs of the map.
+struct FrozenImageTables {
+  template <typename TValue>
+  explicit FrozenImageTables(FrozenImageBuilder<TValue> const& map)
+    : offsets(map.bucketCount() + 1, 0) {
+    for (auto const& pair : map) {
+      auto const hash = seedHash(
+        FrozenImageHash::hash(pair.first.chars(), pair.first.size()), map.seed());
+      ++offsets[FrozenImageReduction::reduce(hash, map.bucketCount()) + 1];
+      fingerprints.push_back(makeFingerprint(hash));
+      FrozenImageEntry entry{};
+      entry.keyOffset = appendChars(pair.first.chars(), pair.first.size());
+      entry.keySize = static_cast<std::uint32_t>(pair.first.size());
+      auto const value = String(pair.second);
+      entry.valueOffset = appendChars(value.chars(), value.size());
+      entry.valueSize = static_cast<std::uint32_t>(value.size());
+      entries.push_back(entry);
+    }
+    for (std::size_t i = 0; i + 1 < offsets.size(); ++i)
+      offsets[i + 1] += offsets[i];
+  }
+
+  std::uint32_t appendChars(char const* ptr, std::size_t size) {
+    auto const offset = chars.size();
+    if (offset + size > std::numeric_limits<std::uint32_t>::max())
+      throw std::length_error("FrozenImage: too many characters");
+    chars.insert(chars.end(), ptr, ptr + size);
+    return static_cast<std::uint32_t>(offset);
+  }
+
+  std::vector<std::uint32_t> offsets;
+  std::vector<std::uint64_t> fingerprints;
+  std::vector<FrozenImageEntry> entries;
+  std::vector<char> chars;
+};
+
+inline void
+writeFrozenImageSection(std::ostream& stream, void const* data, std::size_t size) {
+  static char const padding[8] = {};
+  stream.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+  stream.write(padding,
+               static_cast<std::streamsize>(alignFrozenImageSection(size) - size));
+}
+}
+
+// Writes the binary image of a map, to be read with `FrozenImageMap::fromImage`.
+template <typename TValue>
+void writeFrozenImage(std::ostream& stream, FrozenImageBuilder<TValue> const& map) {
+  Internal::FrozenImageTables const tables(map);
+  FrozenImageHeader header{};
+  std::memcpy(header.magic, Internal::frozenImageMagic, sizeof(header.magic));
+  header.version = FrozenImageHeader::currentVersion;
+  header.byteOrder = FrozenImageHeader::byteOrderMark;
+  header.wordSize = sizeof(std::size_t);
+  header.bucketCount = map.bucketCount();
+  header.maxBucketSize = map.bucketSize();
+  header.elementCount = map.size();
+  header.seed = map.seed();
+  header.charCount = tables.chars.size();
+  Internal::writeFrozenImageSection(stream, &header, sizeof(header));
+  Internal::writeFrozenImageSection(
+    stream, tables.offsets.data(), tables.offsets.size() * sizeof(std::uint32_t));
+  Internal::writeFrozenImageSection(stream,
+                                    tables.fingerprints.data(),
+                                    tables.fingerprints.size() * sizeof(std::uint64_t));
+  Internal::writeFrozenImageSection(
+    stream, tables.entries.data(), tables.entries.size() * sizeof(FrozenImageEntry));
+  Internal::writeFrozenImageSection(stream, tables.chars.data(), tables.chars.size());
+}
+
+// Writes a header that defines the tables of a map as constant arrays and a
+// `FrozenImageMap` over them named `map`, all in namespace `name`.  The arrays have
+// internal linkage, so the header belongs in one translation unit.
+template <typename TValue>
+void writeFrozenHeader(std::ostream& stream,
+                       FrozenImageBuilder<TValue> const& map,
+                       std::string const& name) {
+  Internal::FrozenImageTables const tables(map);
+  stream << "// Generated by ctmgen, do not edit.\n\n"
+            "#pragma once\n\n"
+            "#include <FrozenImage.hpp>\n\n"
+            "namespace "
+         << name << " {\n";
+  // Arrays of zero size are not allowed, empty tables get one unused element.
+  stream << "constexpr std::uint32_t offsets[] = {";
+  for (std::size_t i = 0; i < tables.offsets.size(); ++i)
+    stream << (i % 16 ? "" : "\n  ") << tables.offsets[i] << ",";
+  stream << "};\n\nconstexpr std::uint64_t fingerprints[] = {";
+  for (std::size_t i = 0; i < tables.fingerprints.size(); ++i)
+    stream << (i % 4 ? " " : "\n  ") << tables.fingerprints[i] << "u,";
+  if (tables.fingerprints.empty())
+    stream << "0";
+  stream << "};\n\nconstexpr ctm::FrozenImageEntry entries[] = {";
+  for (std::size_t i = 0; i < tables.entries.size(); ++i) {
+    auto const& entry = tables.entries[i];
+    stream << (i % 4 ? " " : "\n  ") << "{" << entry.keyOffset << "," << entry.keySize
+           << "," << entry.valueOffset << "," << entry.valueSize << "},";
+  }
+  if (tables.entries.empty())
+    stream << "{}";
+  stream << "};\n\nconstexpr char chars[] =\n  \"";
+  static char const digits[] = "01234567";
+  for (std::size_t i = 0; i < tables.chars.size(); ++i) {
+    if (i != 0 && i % 72 == 0)
+      stream << "\"\n  \"";
+    auto const ch = static_cast<unsigned char>(tables.chars[i]);
+    // Octal escapes end after three digits, unlike hexadecimal ones.
+    if (ch < 0x20 || ch >= 0x7f || ch == '"' || ch == '\\' || ch == '?')
+      stream << '\\' << digits[ch >> 6] << digits[(ch >> 3) & 7] << digits[ch & 7];
+    else
+      stream << static_cast<char>(ch);
+  }
+  stream << "\";\n\nconstexpr ctm::FrozenImageMap map{" << map.bucketCount() << "u, "
+         << map.bucketSize() << "u, " << map.size() << "u, " << map.seed()
+         << "u, offsets, fingerprints, entries, chars};\n}\n";
+}
+
+#if CTM_HAS_MMAP
+// Binary image mapped into memory from a file, unmapped when destroyed.
+class FrozenImageFile {
+public:
+  // Throws std::system_error when the file cannot be mapped and std::runtime_error when
+  // it is not a valid image.
+  explicit FrozenImageFile(char const* path) : _data(nullptr), _size(0), _map(empty()) {
+    auto const fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), path);
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+      auto const error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), path);
+    }
+    _size = static_cast<std::size_t>(status.st_size);
+    auto const data
+      = _size ? ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    auto const error = errno;
+    ::close(fd);
+    if (data == MAP_FAILED)
+      throw std::system_error(_size ? error : EINVAL, std::generic_category(), path);
+    _data = data;
+    try {
+      _map = FrozenImageMap::fromImage(_data, _size);
+    } catch (...) {
+      ::munmap(_data, _size);
+      throw;
+    }
+  }
+
+  FrozenImageFile(FrozenImageFile&& other) noexcept
+    : _data(other._data), _size(other._size), _map(other._map) {
+    other._data = nullptr;
+  }
+
+  FrozenImageFile& operator=(FrozenImageFile&& other) noexcept {
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+    std::swap(_map, other._map);
+    return *this;
+  }
+
+  FrozenImageFile(FrozenImageFile const&) = delete;
+
+  FrozenImageFile& operator=(FrozenImageFile const&) = delete;
+
+  ~FrozenImageFile() {
+    if (_data)
+      ::munmap(_data, _size);
+  }
+
+  FrozenImageMap const& map() const { return _map; }
+
+private:
+  static FrozenImageMap empty() {
+    return FrozenImageMap(1, 0, 0, 0, nullptr, nullptr, nullptr, nullptr);
+  }
+
+  void* _data;
+  std::size_t _size;
+  FrozenImageMap _map;
+};
+#endif
+}
@@ -8,9 +8,22 @@
 #define CTM_BYTES_HASH_ALGORITHM_INTEGER_SIZE_DEFAULT 4
 #endif
 
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <type_traits>
 
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define CTM_HAS_BUILTIN_IS_CONSTANT_EVALUATED 1
+#endif
+#endif
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#define CTM_HAS_STRING_VIEW 1
+#endif
+
 namespace ctm {
 namespace internal {
 template <typename TResult, typename TArg>
@@ -189,10 +202,178 @@ hashBytesWithMurmur(char const* ptr, std::size_t size, std::size_t seed) {
   }
   }
 }
+
+template <std::size_t N>
+constexpr std::size_t mixBits(std::size_t value) {
+  switch (N) {
+  case 4: {
+    // Finalization mix of Murmur3 for 32-bit std::size_t.
+
+    value ^= value >> 16;
+    value *= static_cast<std::size_t>(0x85ebca6bUL);
+    value ^= value >> 13;
+    value *= static_cast<std::size_t>(0xc2b2ae35UL);
+    value ^= value >> 16;
+    return value;
+  }
+  case 8: {
+    // Finalization mix of SplitMix64 for 64-bit std::size_t.
+
+    value ^= value >> 30;
+    value *= static_cast<std::size_t>(0xbf58476d1ce4e5b9ULL);
+    value ^= value >> 27;
+    value *= static_cast<std::size_t>(0x94d049bb133111ebULL);
+    value ^= value >> 31;
+    return value;
+  }
+  default: {
+    // Dummy mix implementation for unusual sizeof(std::size_t).
+
+    return value * 131 + (value >> 7);
+  }
+  }
+}
+
+template <std::size_t N>
+constexpr std::size_t multiplyHigh(std::size_t lhs, std::size_t rhs) {
+  switch (N) {
+  case 4: {
+    return static_cast<std::size_t>(
+      (static_cast<std::uint64_t>(lhs) * static_cast<std::uint64_t>(rhs)) >> 32);
+  }
+  case 8: {
+#ifdef __SIZEOF_INT128__
+    return static_cast<std::size_t>(
+      (static_cast<unsigned __int128>(lhs) * static_cast<unsigned __int128>(rhs)) >> 64);
+#else
+    auto const lhs_low = static_cast<std::uint64_t>(lhs) & 0xffffffffULL;
+    auto const lhs_high = static_cast<std::uint64_t>(lhs) >> 32;
+    auto const rhs_low = static_cast<std::uint64_t>(rhs) & 0xffffffffULL;
+    auto const rhs_high = static_cast<std::uint64_t>(rhs) >> 32;
+    auto const low_low = lhs_low * rhs_low;
+    auto const high_low = lhs_high * rhs_low;
+    auto const low_high = lhs_low * rhs_high;
+    auto const cross = (low_low >> 32) + (high_low & 0xffffffffULL) + low_high;
+    return static_cast<std::size_t>((high_low >> 32) + (cross >> 32)
+                                    + lhs_high * rhs_high);
+#endif
+  }
+  default: {
+    // Dummy implementation for unusual sizeof(std::size_t), good enough for reductions.
+
+    return lhs / (static_cast<std::size_t>(-1) / rhs + 1);
+  }
+  }
+}
+
+// Upper half of the full-width product of two values.
+constexpr std::size_t multiplyHigh(std::size_t lhs, std::size_t rhs) {
+  return multiplyHigh<sizeof(std::size_t)>(lhs, rhs);
+}
+
+// Scrambles all bits of an already computed hash value.  Used where a hash has to be
+// split into several independent parts, because identity hashes of integers and short
+// strings leave most of the high bits untouched.
+constexpr std::size_t mixHash(std::size_t value) {
+  return mixBits<sizeof(std::size_t)>(value);
+}
+
+// Loads `sizeof(T)` bytes in little-endian order.  At run time on little-endian
+// targets that is a single unaligned load, constant evaluation assembles the bytes.
+template <typename T>
+constexpr T loadWord(char const* ptr) {
+#if CTM_HAS_BUILTIN_IS_CONSTANT_EVALUATED && defined(__BYTE_ORDER__)                    \
+  && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (!__builtin_is_constant_evaluated()) {
+    T result = 0;
+    std::memcpy(&result, ptr, sizeof(T));
+    return result;
+  }
+#endif
+  T result = 0;
+  for (auto i = sizeof(T); i != 0; --i)
+    result = (result << 8) | static_cast<unsigned char>(ptr[i - 1]);
+  return result;
+}
+
+// Folds the full-width product of two values into one.
+constexpr std::size_t foldedMultiply(std::size_t lhs, std::size_t rhs) {
+  return (lhs * rhs) ^ multiplyHigh(lhs, rhs);
+}
+
+template <std::size_t N>
+constexpr std::size_t
+hashBytesWithWy(char const* ptr, std::size_t size, std::size_t seed) {
+  switch (N) {
+  case 8: {
+    // Implementation of wyhash for 64-bit std::size_t, 16 to 48 bytes per step.
+
+    constexpr std::size_t secret0 = static_cast<std::size_t>(0xa0761d6478bd642fULL);
+    constexpr std::size_t secret1 = static_cast<std::size_t>(0xe7037ed1a0b428dbULL);
+    constexpr std::size_t secret2 = static_cast<std::size_t>(0x8ebc6af09c88c6e3ULL);
+    constexpr std::size_t secret3 = static_cast<std::size_t>(0x589965cc75374cc3ULL);
+
+    seed ^= foldedMultiply(seed ^ secret0, secret1);
+    std::size_t a = 0;
+    std::size_t b = 0;
+    if (size <= 16) {
+      if (size >= 4) {
+        auto const step = (size >> 3) << 2;
+        a = (static_cast<std::size_t>(loadWord<std::uint32_t>(ptr)) << 32)
+            | loadWord<std::uint32_t>(ptr + step);
+        b = (static_cast<std::size_t>(loadWord<std::uint32_t>(ptr + size - 4)) << 32)
+            | loadWord<std::uint32_t>(ptr + size - 4 - step);
+      } else if (size > 0) {
+        a = (static_cast<std::size_t>(static_cast<unsigned char>(ptr[0])) << 16)
+            | (static_cast<std::size_t>(static_cast<unsigned char>(ptr[size >> 1])) << 8)
+            | static_cast<unsigned char>(ptr[size - 1]);
+      }
+    } else {
+      auto rest = size;
+      auto p = ptr;
+      if (rest > 48) {
+        auto seed1 = seed;
+        auto seed2 = seed;
+        do {
+          seed = foldedMultiply(loadWord<std::size_t>(p) ^ secret1,
+                                loadWord<std::size_t>(p + 8) ^ seed);
+          seed1 = foldedMultiply(loadWord<std::size_t>(p + 16) ^ secret2,
+                                 loadWord<std::size_t>(p + 24) ^ seed1);
+          seed2 = foldedMultiply(loadWord<std::size_t>(p + 32) ^ secret3,
+                                 loadWord<std::size_t>(p + 40) ^ seed2);
+          p += 48;
+          rest -= 48;
+        } while (rest > 48);
+        seed ^= seed1 ^ seed2;
+      }
+      while (rest > 16) {
+        seed = foldedMultiply(loadWord<std::size_t>(p) ^ secret1,
+                              loadWord<std::size_t>(p + 8) ^ seed);
+        p += 16;
+        rest -= 16;
+      }
+      a = loadWord<std::size_t>(p + rest - 16);
+      b = loadWord<std::size_t>(p + rest - 8);
+    }
+    a ^= secret1;
+    b ^= seed;
+    auto const low = a * b;
+    auto const high = multiplyHigh(a, b);
+    return foldedMultiply(low ^ secret0 ^ size, high ^ secret1);
+  }
+  default: {
+    // No word-at-a-time variant for other sizes of std::size_t, fall back to Murmur.
+
+    return hashBytesWithMurmur<N>(ptr, size, seed);
+  }
+  }
+}
 }
 
 template <std::size_t N = sizeof(std::size_t)>
 struct FnvBytesHash {
+  constexpr static char const* name() { return "fnv"; }
+
   constexpr static std::size_t hash(char const* ptr,
                                     std::size_t size,
                                     std::size_t seed
@@ -203,6 +384,8 @@ struct FnvBytesHash {
 
 template <std::size_t N = sizeof(std::size_t)>
 struct MurmurBytesHash {
+  constexpr static char const* name() { return "murmur"; }
+
   constexpr static std::size_t hash(char const* ptr,
                                     std::size_t size,
                                     std::size_t seed
@@ -211,6 +394,19 @@ struct MurmurBytesHash {
   }
 };
 
+// Wyhash, reads up to 48 bytes per step, the fastest one for keys longer than a few
+// bytes.  Requires a 64-bit std::size_t, otherwise it is Murmur.
+template <std::size_t N = sizeof(std::size_t)>
+struct WyBytesHash {
+  constexpr static char const* name() { return "wyhash"; }
+
+  constexpr static std::size_t hash(char const* ptr,
+                                    std::size_t size,
+                                    std::size_t seed = 0) {
+    return internal::hashBytesWithWy<N>(ptr, size, seed);
+  }
+};
+
 struct BytesHash
   : CTM_BYTES_HASH_ALGORITHM_DEFAULT<CTM_BYTES_HASH_ALGORITHM_INTEGER_SIZE_DEFAULT> {};
 
@@ -242,4 +438,13 @@ struct Hash<std::string> : internal::HashBase<std::size_t, std::string> {
     return BytesHash::hash(string.data(), string.length());
   }
 };
+
+#if CTM_HAS_STRING_VIEW
+template <>
+struct Hash<std::string_view> : internal::HashBase<std::size_t, std::string_view> {
+  constexpr std::size_t operator()(std::string_view string) const noexcept {
+    return BytesHash::hash(string.data(), string.size());
+  }
+};
+#endif
 }
@@ -1,13 +1,78 @@
 #pragma once
 
+#include <cstdint>
 #include <limits>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "Hash.hpp"
 
+#ifdef CTM_HASH_MAP_COUNTERS
+#include "LookupSite.hpp"
+#endif
+
+// Number of keys the bucket count search may visit.  Large maps try fewer bucket counts,
+// so the constant evaluation stays within the default compiler limits.
+#ifndef CTM_HASH_MAP_BUCKET_COUNT_SEARCH_BUDGET
+#define CTM_HASH_MAP_BUCKET_COUNT_SEARCH_BUDGET 131072
+#endif
+
+// Number of keys a batched lookup hashes and prefetches before it resolves them.
+#ifndef CTM_HASH_MAP_BATCH_SIZE
+#define CTM_HASH_MAP_BATCH_SIZE 16
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CTM_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define CTM_PREFETCH(address)
+#endif
+
+// Number of keys the search for a hash seed may visit and the largest number of seeds it
+// tries.  Zero budget disables the seed search.
+#ifndef CTM_HASH_MAP_SEED_SEARCH_BUDGET
+#define CTM_HASH_MAP_SEED_SEARCH_BUDGET 16384
+#endif
+
+#ifndef CTM_HASH_MAP_MAX_SEED_COUNT
+#define CTM_HASH_MAP_MAX_SEED_COUNT 16
+#endif
+
+// Largest `hashMapSpecWork` a spec may take, checked only when it is built with the
+// default load factors.  Zero is no limit.
+#ifndef CTM_HASH_MAP_MAX_SPEC_WORK
+#define CTM_HASH_MAP_MAX_SPEC_WORK 0
+#endif
+
+// Largest share of the slots of a GroupStorage map that hold keys, in percent.  Misses
+// read more groups as it grows.
+#ifndef CTM_HASH_MAP_GROUP_MAX_LOAD_PERCENT
+#define CTM_HASH_MAP_GROUP_MAX_LOAD_PERCENT 75
+#endif
+
+// Lookups through `CTM_HASH_MAP_FIND` and `CTM_HASH_MAP_FIND_PAIR` count their hits,
+// misses and probed slots in a `ctm::LookupSite` per call site when
+// `CTM_HASH_MAP_COUNTERS` is defined, otherwise they are plain `find` and `findPair`.
+#ifdef CTM_HASH_MAP_COUNTERS
+#define CTM_HASH_MAP_COUNTED_LOOKUP(method, map, key)            \
+  ([&]() -> decltype(auto) {                                     \
+    static ::ctm::LookupSite ctm_lookup_site(__FILE__, __LINE__); \
+    return (map).method((key), ctm_lookup_site);                 \
+  }())
+#define CTM_HASH_MAP_FIND(map, key) CTM_HASH_MAP_COUNTED_LOOKUP(find, map, key)
+#define CTM_HASH_MAP_FIND_PAIR(map, key) CTM_HASH_MAP_COUNTED_LOOKUP(findPair, map, key)
+#else
+#define CTM_HASH_MAP_FIND(map, key) ((map).find(key))
+#define CTM_HASH_MAP_FIND_PAIR(map, key) ((map).findPair(key))
+#endif
+
 namespace ctm {
 template <typename T, std::size_t N>
 struct Array {
@@ -30,6 +95,21 @@ struct Array {
   T data[N];
 };
 
+namespace Internal {
+// Compares `size` bytes of two strings, with memcmp when not evaluated at compile time.
+constexpr bool equalChars(char const* lhs, char const* rhs, std::size_t size) {
+#if CTM_HAS_BUILTIN_IS_CONSTANT_EVALUATED
+  if (!__builtin_is_constant_evaluated())
+    return size == 0 || std::memcmp(lhs, rhs, size) == 0;
+#endif
+  for (auto lhs_end = lhs + size; lhs != lhs_end; ++lhs, ++rhs) {
+    if (*lhs != *rhs)
+      return false;
+  }
+  return true;
+}
+}
+
 class String {
 public:
   constexpr String() : _ptr(nullptr), _size(0) {}
@@ -39,12 +119,19 @@ public:
 
   String(std::string const& string) : _ptr(string.data()), _size(string.size()) {}
 
+#if CTM_HAS_STRING_VIEW
+  constexpr String(std::string_view string) : _ptr(string.data()), _size(string.size()) {}
+#endif
+
   constexpr String(char const* ptr) : _ptr(ptr), _size(0) {
     while ((*ptr++) != '\0') {
     }
     _size = static_cast<std::size_t>(ptr - _ptr - 1);
   }
 
+  // Characters do not have to be terminated by a null character.
+  constexpr String(char const* ptr, std::size_t size) : _ptr(ptr), _size(size) {}
+
   constexpr char const* chars() const { return _ptr; }
 
   constexpr std::size_t size() const { return _size; }
@@ -56,25 +143,33 @@ public:
   std::string toStdString() const { return std::string(_ptr, _size); }
 
   constexpr bool operator==(String const& other) const {
-    if (_size != other._size)
-      return false;
-    for (auto lhs_ptr = _ptr, rhs_ptr = other._ptr; *lhs_ptr != '\0';
-         ++lhs_ptr, ++rhs_ptr) {
-      if (*lhs_ptr != *rhs_ptr)
-        return false;
-    }
-    return true;
+    return _size == other._size && Internal::equalChars(_ptr, other._ptr, _size);
   }
 
+  // The characters of the string do not have to be terminated by a null character.
   constexpr bool operator==(char const* chars) const {
-    auto lhs_ptr = _ptr, rhs_ptr = chars;
-    for (; *lhs_ptr != '\0'; ++lhs_ptr, ++rhs_ptr) {
-      if (*rhs_ptr == '\0')
+    if (!_ptr)
+      return false;
+    for (auto lhs_ptr = _ptr, lhs_end = _ptr + _size; lhs_ptr != lhs_end;
+         ++lhs_ptr, ++chars) {
+      if (*chars == '\0')
         return false;
-      if (*lhs_ptr != *rhs_ptr)
+      if (*lhs_ptr != *chars)
         return false;
     }
-    return *rhs_ptr == '\0';
+    return *chars == '\0';
+  }
+
+  // Orders strings by their bytes as unsigned characters, as `std::string` does.
+  constexpr bool operator<(String const& other) const {
+    auto const size = _size < other._size ? _size : other._size;
+    for (std::size_t i = 0; i < size; ++i) {
+      auto const lhs = static_cast<unsigned char>(_ptr[i]);
+      auto const rhs = static_cast<unsigned char>(other._ptr[i]);
+      if (lhs != rhs)
+        return lhs < rhs;
+    }
+    return _size < other._size;
   }
 
   constexpr operator bool() const { return _ptr; }
@@ -89,10 +184,41 @@ struct Hash<String> {
   using ResultType = std::size_t;
   using ArgumentType = String;
 
-  constexpr std::size_t operator()(String const& string) { return string.hash(); }
+  constexpr std::size_t operator()(String const& string) const noexcept {
+    return string.hash();
+  }
 };
 
 namespace Internal {
+// Hash of a key in a map.  String keys are hashed with the bytes hash of the map, other
+// keys with their `Hash` specialisation.
+template <typename TBytesHash>
+struct KeyHash {
+  template <typename U>
+  constexpr std::size_t operator()(U const& key) const noexcept {
+    return Hash<U>()(key);
+  }
+
+  constexpr std::size_t operator()(String const& key) const noexcept {
+    return TBytesHash::hash(key.chars(), key.size());
+  }
+};
+
+// Lookup keys are converted to the key type of a map once, so string keys are measured
+// only once and then hashed and compared with their known length.
+template <typename TKey>
+struct LookupKey {
+  template <typename U>
+  constexpr static U const& make(U const& key) {
+    return key;
+  }
+};
+
+template <>
+struct LookupKey<String> {
+  constexpr static String make(String const& key) { return key; }
+};
+
 template <typename THead, typename... TTail>
 struct TupleHeadTypeProvider {
   using type = THead;
@@ -208,120 +334,1216 @@ constexpr auto assignTuples(std::tuple<TArgs...>& lhs, std::tuple<TArgs...> cons
 }
 }
 
-template <typename T, std::size_t N>
+// Key hashed once and then looked up in several maps that hash their keys with
+// `TKeyHash`, e.g. the `KeyHash` of their specs.  Maps only scramble the hash with their
+// seeds.  A constexpr key built from a literal carries a hash computed at compile time.
+template <typename TKey, typename TKeyHash = Internal::KeyHash<BytesHash>>
+class HashedKey {
+public:
+  constexpr HashedKey(TKey const& key) : _key(key), _hash(TKeyHash()(key)) {}
+
+  constexpr TKey const& key() const { return _key; }
+
+  constexpr std::size_t hash() const { return _hash; }
+
+private:
+  TKey _key;
+  std::size_t _hash;
+};
+
+// Reductions of a hash value to a bucket index.  The builder starts from the
+// `bucketCount` closest to the requested one and walks over `nextBucketCount`, so it
+// only ever tries bucket counts the reduction supports.  The same `reduce` is used by
+// the builder and by lookups.
+
+// `hash % M`, any bucket count.
+struct ModuloReduction {
+  constexpr static char const* name() { return "modulo"; }
+
+  constexpr static std::size_t bucketCount(std::size_t count) {
+    return count ? count : 1;
+  }
+
+  constexpr static std::size_t nextBucketCount(std::size_t count) { return count + 1; }
+
+  constexpr static std::size_t reduce(std::size_t hash, std::size_t bucket_count) {
+    return hash % bucket_count;
+  }
+};
+
+// `hash & (M - 1)`, power-of-two bucket counts.  Uses only the low bits of the hash, so
+// hashes of integer keys that share their low bits end up in the same bucket.
+struct MaskReduction {
+  constexpr static char const* name() { return "mask"; }
+
+  constexpr static std::size_t bucketCount(std::size_t count) {
+    std::size_t result = 1;
+    while (result < count)
+      result <<= 1;
+    return result;
+  }
+
+  constexpr static std::size_t nextBucketCount(std::size_t count) { return count << 1; }
+
+  constexpr static std::size_t reduce(std::size_t hash, std::size_t bucket_count) {
+    return hash & (bucket_count - 1);
+  }
+};
+
+// Lemire's fastrange, the upper half of `hash * M`, any bucket count.  The hash is first
+// multiplied by an odd constant to move the entropy of the low bits up, otherwise small
+// integer keys and short strings would all land in the first bucket.
+struct FastRangeReduction {
+  constexpr static char const* name() { return "fastrange"; }
+
+  constexpr static std::size_t bucketCount(std::size_t count) {
+    return count ? count : 1;
+  }
+
+  constexpr static std::size_t nextBucketCount(std::size_t count) { return count + 1; }
+
+  constexpr static std::size_t reduce(std::size_t hash, std::size_t bucket_count) {
+    return internal::multiplyHigh(hash * static_cast<std::size_t>(0x9e3779b97f4a7c15ULL),
+                                  bucket_count);
+  }
+};
+
+template <typename T,
+          std::size_t N,
+          typename TReduction = ModuloReduction,
+          typename TBytesHash = BytesHash>
 struct HashMapSpec {
   using KeyType = typename T::first_type;
   using ValueType = typename T::second_type;
   using PairType = T;
+  using Reduction = TReduction;
+  using KeyHash = Internal::KeyHash<TBytesHash>;
+  using BytesHash = TBytesHash;
+
+  // Number of pairs, repeated keys included.
+  constexpr static std::size_t pairCount = N;
 
   std::size_t maxBucketSize;
   std::size_t bucketCount;
   std::size_t elementCount;
+  std::size_t seed;
   Array<PairType, N> dataPairs;
   Array<std::size_t, N> bucketIndexes;
   Array<bool, N> nonuniquenesses;
+  Array<std::size_t, N> hashes;
 };
 
 namespace Internal {
-template <typename... TArgs>
+// Size of the open addressing tables the builders use to find equal values in linear
+// time: a power of two, at most half full.
+constexpr std::size_t probeTableSize(std::size_t count) {
+  std::size_t result = 2;
+  while (result < 2 * count)
+    result <<= 1;
+  return result;
+}
+
+// Marks every repeated key after its first occurrence and returns the number of unique
+// keys.  Keys are compared only when their hashes are equal.  `owners`, when given,
+// receives the index of the first occurrence of the key of every pair.
+template <typename TPair, std::size_t N>
+constexpr std::size_t markNonuniquenesses(Array<TPair, N> const& data_pairs,
+                                          Array<std::size_t, N> const& hashes,
+                                          Array<bool, N>& nonuniquenesses,
+                                          Array<std::size_t, N>* owners = nullptr) {
+  constexpr auto table_size = probeTableSize(N);
+  // Indexes of the unique keys plus one, zero is an empty slot.
+  Array<std::size_t, table_size> table{};
+  std::size_t element_count = 0;
+  for (std::size_t i = 0; i < hashes.size(); ++i) {
+    auto slot = internal::mixHash(hashes[i]) & (table_size - 1);
+    for (; table[slot] != 0; slot = (slot + 1) & (table_size - 1)) {
+      auto const j = table[slot] - 1;
+      if (hashes[j] == hashes[i] && data_pairs[j].first == data_pairs[i].first) {
+        nonuniquenesses[i] = true;
+        if (owners)
+          (*owners)[i] = j;
+        break;
+      }
+    }
+    if (!nonuniquenesses[i]) {
+      table[slot] = i + 1;
+      ++element_count;
+      if (owners)
+        (*owners)[i] = i;
+    }
+  }
+  return element_count;
+}
+
+// Size of the largest bucket for the given bucket count.  Buckets are counted in a
+// histogram, unless the bucket count is too large for it, then the bucket indexes are
+// counted in an open addressing table.
+template <typename TReduction, std::size_t N>
+constexpr std::size_t maxBucketSize(Array<std::size_t, N> const& hashes,
+                                    Array<bool, N> const& nonuniquenesses,
+                                    std::size_t bucket_count) {
+  constexpr auto table_size = probeTableSize(N);
+  Array<std::size_t, table_size> counts{};
+  std::size_t result = 0;
+  // Pointers instead of `operator[]` make a noticeable difference in the number of
+  // constant evaluation steps.
+  auto const counts_ptr = counts.begin();
+  auto nonuniqueness_ptr = nonuniquenesses.begin();
+  if (bucket_count <= table_size) {
+    for (auto hash_ptr = hashes.begin(), hash_end = hashes.end(); hash_ptr != hash_end;
+         ++hash_ptr, ++nonuniqueness_ptr) {
+      if (*nonuniqueness_ptr)
+        continue;
+      auto const size = ++counts_ptr[TReduction::reduce(*hash_ptr, bucket_count)];
+      if (size > result)
+        result = size;
+    }
+    return result;
+  }
+  Array<std::size_t, table_size> indexes{};
+  for (auto hash_ptr = hashes.begin(), hash_end = hashes.end(); hash_ptr != hash_end;
+       ++hash_ptr, ++nonuniqueness_ptr) {
+    if (*nonuniqueness_ptr)
+      continue;
+    auto const index = TReduction::reduce(*hash_ptr, bucket_count);
+    auto slot = internal::mixHash(index) & (table_size - 1);
+    while (counts_ptr[slot] != 0 && indexes[slot] != index)
+      slot = (slot + 1) & (table_size - 1);
+    indexes[slot] = index;
+    auto const size = ++counts_ptr[slot];
+    if (size > result)
+      result = size;
+  }
+  return result;
+}
+
+// Hash of a key scrambled with a seed, the zero seed leaves the hash as it is.  Seeds
+// let the builder redistribute the keys over the buckets without rehashing them.
+constexpr std::size_t seedHash(std::size_t hash, std::size_t seed) {
+  return seed ? internal::mixHash(hash ^ seed) : hash;
+}
+
+constexpr std::size_t makeSeed(std::size_t index) {
+  return index * static_cast<std::size_t>(0x9e3779b97f4a7c15ULL);
+}
+
+// `maxBucketSize` of the hashes of the compile-time builders.
+template <typename TReduction, std::size_t N>
+struct ArrayBucketSizes {
+  constexpr std::size_t operator()(std::size_t bucket_count) const {
+    return maxBucketSize<TReduction>(hashes, nonuniquenesses, bucket_count);
+  }
+
+  Array<std::size_t, N> const& hashes;
+  Array<bool, N> const& nonuniquenesses;
+};
+
+// Tries bucket counts from `first_bucket_count` until the load factor drops below
+// `min_load_factor` or the buckets hold a single key.  Keeps the smallest maximal bucket
+// size at the fewest buckets in `best_bucket_count` and `best_max_bucket_size`, returns
+// whether they have been improved.  `max_bucket_size` gives the size of the largest
+// bucket for a bucket count.
+template <typename TReduction, typename TBucketSizes>
+constexpr bool searchBucketCount(TBucketSizes const& max_bucket_size,
+                                 std::size_t element_count,
+                                 double min_load_factor,
+                                 std::size_t first_bucket_count,
+                                 std::size_t bucket_count_stride,
+                                 std::size_t& best_bucket_count,
+                                 std::size_t& best_max_bucket_size) {
+  bool is_improved = false;
+  std::size_t current_bucket_count = first_bucket_count;
+  while (true) {
+    std::size_t const current_max_bucket_size
+      = max_bucket_size(current_bucket_count);
+    if (current_max_bucket_size < best_max_bucket_size
+        || (current_max_bucket_size == best_max_bucket_size
+            && current_bucket_count < best_bucket_count)) {
+      best_bucket_count = current_bucket_count;
+      best_max_bucket_size = current_max_bucket_size;
+      is_improved = true;
+    }
+    if (current_max_bucket_size <= 1) {
+      break;
+    }
+    auto const next_bucket_count = current_bucket_count + bucket_count_stride;
+    while (current_bucket_count < next_bucket_count)
+      current_bucket_count = TReduction::nextBucketCount(current_bucket_count);
+    if ((float)element_count / current_bucket_count < min_load_factor) {
+      break;
+    }
+  }
+  return is_improved;
+}
+
+// Bucket sizes that never reach single keys, counting the bucket counts they are asked
+// for.
+struct CountingBucketSizes {
+  constexpr std::size_t operator()(std::size_t) const {
+    ++count;
+    return 2;
+  }
+
+  std::size_t& count;
+};
+
+// Number of bucket counts `searchBucketCount` tries at most, when no bucket count gives
+// buckets of single keys.
+template <typename TReduction>
+constexpr std::size_t bucketCountTryCount(std::size_t element_count,
+                                          double min_load_factor,
+                                          std::size_t first_bucket_count,
+                                          std::size_t bucket_count_stride) {
+  std::size_t result = 0;
+  std::size_t best_bucket_count = first_bucket_count;
+  std::size_t best_max_bucket_size = 2;
+  searchBucketCount<TReduction>(CountingBucketSizes{result},
+                                element_count,
+                                min_load_factor,
+                                first_bucket_count,
+                                bucket_count_stride,
+                                best_bucket_count,
+                                best_max_bucket_size);
+  return result;
+}
+
+// Upper bound of the work of `makeHashMapSpecImpl`, in keys and table slots visited,
+// following its search budgets.  The hashing of the key bytes is not counted.
+template <typename TReduction>
+constexpr std::size_t
+specWork(std::size_t key_count, double load_factor, double min_load_factor) {
+  if (key_count == 0)
+    return 0;
+  auto const table_size = probeTableSize(key_count);
+  // A bucket count try clears a table and visits every key.
+  auto const try_work = table_size + key_count;
+  std::size_t const first_bucket_count
+    = TReduction::bucketCount(static_cast<std::size_t>(key_count / load_factor));
+  auto const last_bucket_count = static_cast<std::size_t>(key_count / min_load_factor);
+  auto const try_count = CTM_HASH_MAP_BUCKET_COUNT_SEARCH_BUDGET / key_count + 1;
+  std::size_t const bucket_count_stride
+    = last_bucket_count > first_bucket_count
+        ? (last_bucket_count - first_bucket_count) / try_count + 1
+        : 1;
+  // Hashes, the duplicate check, the bucket indexes.
+  std::size_t result = 4 * key_count + table_size;
+  result += try_work
+            * bucketCountTryCount<TReduction>(
+              key_count, min_load_factor, first_bucket_count, bucket_count_stride);
+  std::size_t seed_count = CTM_HASH_MAP_SEED_SEARCH_BUDGET / key_count;
+  if (seed_count > CTM_HASH_MAP_MAX_SEED_COUNT)
+    seed_count = CTM_HASH_MAP_MAX_SEED_COUNT;
+  if (seed_count == 0)
+    return result;
+  std::size_t const seed_bucket_count_stride
+    = last_bucket_count > first_bucket_count
+        ? (last_bucket_count - first_bucket_count)
+              / (CTM_HASH_MAP_SEED_SEARCH_BUDGET / (seed_count * key_count))
+            + 1
+        : 1;
+  return result
+         + seed_count
+             * (key_count
+                + try_work
+                    * bucketCountTryCount<TReduction>(key_count,
+                                                      min_load_factor,
+                                                      first_bucket_count,
+                                                      seed_bucket_count_stride));
+}
+
+// Checks a spec of `N` keys with the default load factors against
+// CTM_HASH_MAP_MAX_SPEC_WORK.  Specs with explicit load factors are not checked, their
+// factors are function arguments, not constants.
+template <typename TReduction, std::size_t N>
+constexpr void checkDefaultSpecWork() {
+  static_assert(CTM_HASH_MAP_MAX_SPEC_WORK == 0
+                  || specWork<TReduction>(N, 1.0, 0.5) <= CTM_HASH_MAP_MAX_SPEC_WORK,
+                "The spec exceeds CTM_HASH_MAP_MAX_SPEC_WORK, build a FrozenHashMap at "
+                "runtime or generate the map with ctmgen");
+}
+
+template <typename TReduction, typename TBytesHash, typename... TArgs>
 constexpr auto
 makeHashMapSpecImpl(double load_factor, double min_load_factor, TArgs&&... args) {
   using tuple_type = typename Internal::TupleHeadTypeProvider<TArgs...>::type;
   using tuple_pair_converter_type = Internal::TupleToPairConversion<tuple_type>;
   using pair_type = typename tuple_pair_converter_type::PairType;
-
   Array<pair_type, sizeof...(args)> const data_pairs{
     {tuple_pair_converter_type::makePairFromTuple(args)...}};
+  Array<std::size_t, sizeof...(args)> key_hashes{};
+  Array<std::size_t, sizeof...(args)> hashes{};
   Array<std::size_t, sizeof...(args)> bucket_indexes{};
   Array<bool, sizeof...(args)> nonuniquenesses{};
-  for (std::size_t i = 0; i < bucket_indexes.size(); ++i) {
-    bucket_indexes[i]
-      = Hash<typename tuple_pair_converter_type::KeyType>()(data_pairs[i].first);
+  for (std::size_t i = 0; i < key_hashes.size(); ++i) {
+    key_hashes[i] = KeyHash<TBytesHash>()(data_pairs[i].first);
+  }
+  std::size_t const element_count
+    = markNonuniquenesses(data_pairs, key_hashes, nonuniquenesses);
+  std::size_t const first_bucket_count
+    = TReduction::bucketCount(static_cast<std::size_t>(element_count / load_factor));
+  // Bucket counts between the first and the last one allowed by `min_load_factor` are
+  // tried with a stride that keeps the search within its budget, small maps are searched
+  // exhaustively.
+  auto const last_bucket_count
+    = static_cast<std::size_t>(element_count / min_load_factor);
+  auto const try_count = CTM_HASH_MAP_BUCKET_COUNT_SEARCH_BUDGET / element_count + 1;
+  std::size_t const bucket_count_stride
+    = last_bucket_count > first_bucket_count
+        ? (last_bucket_count - first_bucket_count) / try_count + 1
+        : 1;
+  std::size_t best_bucket_count = first_bucket_count;
+  std::size_t best_max_bucket_size = std::numeric_limits<std::size_t>::max();
+  using bucket_sizes_type = ArrayBucketSizes<TReduction, sizeof...(TArgs)>;
+  searchBucketCount<TReduction>(bucket_sizes_type{key_hashes, nonuniquenesses},
+                                element_count,
+                                min_load_factor,
+                                first_bucket_count,
+                                bucket_count_stride,
+                                best_bucket_count,
+                                best_max_bucket_size);
+  // Then the same search for the seeded hashes, every seed gets an equal share of the
+  // seed search budget.
+  std::size_t best_seed = 0;
+  std::size_t seed_count = CTM_HASH_MAP_SEED_SEARCH_BUDGET / element_count;
+  if (seed_count > CTM_HASH_MAP_MAX_SEED_COUNT)
+    seed_count = CTM_HASH_MAP_MAX_SEED_COUNT;
+  std::size_t const seed_bucket_count_stride
+    = seed_count && last_bucket_count > first_bucket_count
+        ? (last_bucket_count - first_bucket_count)
+              / (CTM_HASH_MAP_SEED_SEARCH_BUDGET / (seed_count * element_count))
+            + 1
+        : 1;
+  for (std::size_t i = 1; i <= seed_count; ++i) {
+    if (best_max_bucket_size <= 1 && best_bucket_count == first_bucket_count)
+      break;
+    auto const seed = makeSeed(i);
+    for (std::size_t j = 0; j < hashes.size(); ++j)
+      hashes[j] = seedHash(key_hashes[j], seed);
+    if (searchBucketCount<TReduction>(bucket_sizes_type{hashes, nonuniquenesses},
+                                      element_count,
+                                      min_load_factor,
+                                      first_bucket_count,
+                                      seed_bucket_count_stride,
+                                      best_bucket_count,
+                                      best_max_bucket_size))
+      best_seed = seed;
   }
+  for (std::size_t i = 0; i < hashes.size(); ++i)
+    hashes[i] = seedHash(key_hashes[i], best_seed);
   for (std::size_t i = 0; i < bucket_indexes.size(); ++i) {
-    if (nonuniquenesses[i])
-      continue;
-    for (std::size_t j = i + 1; j < bucket_indexes.size(); ++j) {
-      if (bucket_indexes[j] == bucket_indexes[i]) {
-        if (data_pairs[j].first == data_pairs[i].first) {
-          nonuniquenesses[j] = true;
-        }
+    if (!nonuniquenesses[i])
+      bucket_indexes[i] = TReduction::reduce(hashes[i], best_bucket_count);
+  }
+  return HashMapSpec<pair_type, sizeof...(TArgs), TReduction, TBytesHash>{
+    best_max_bucket_size,
+    best_bucket_count,
+    element_count,
+    best_seed,
+    data_pairs,
+    bucket_indexes,
+    nonuniquenesses,
+    hashes};
+}
+
+// Fingerprint of an occupied slot: the full hash of its key with the lowest bit set,
+// zero marks an empty slot.
+constexpr std::size_t makeFingerprint(std::size_t hash) { return hash | 1; }
+
+// Keys that are not cheaper to compare than their hashes.
+template <typename TKey>
+struct HasFingerprints : std::integral_constant<bool, !std::is_scalar<TKey>::value> {};
+
+// Name of a reduction or a bytes hash, "custom" for policies without a `name`.
+template <typename T, typename = void>
+struct PolicyName {
+  constexpr static char const* get() { return "custom"; }
+};
+
+template <typename T>
+struct PolicyName<T, decltype(void(T::name()))> {
+  constexpr static char const* get() { return T::name(); }
+};
+
+// Occupancy histogram and probe lengths of `M` buckets whose k-th key is found with k
+// probes.
+template <std::size_t M, typename TBuckets, typename TStats>
+constexpr void addBucketStats(TBuckets const& buckets, TStats& stats) {
+  std::size_t key_count = 0;
+  std::size_t hit_probe_count = 0;
+  std::size_t miss_probe_count = 0;
+  for (std::size_t i = 0; i < M; ++i) {
+    auto const occupancy = buckets.occupancy(i);
+    ++stats.occupancyHistogram[occupancy];
+    key_count += occupancy;
+    hit_probe_count += occupancy * (occupancy + 1) / 2;
+    if (stats.maxHitProbeLength < occupancy)
+      stats.maxHitProbeLength = occupancy;
+    miss_probe_count += buckets.probeLength(i, 0, nullptr);
+  }
+  stats.averageHitProbeLength
+    = key_count ? static_cast<double>(hit_probe_count) / static_cast<double>(key_count)
+                : 0.0;
+  stats.averageMissProbeLength
+    = static_cast<double>(miss_probe_count) / static_cast<double>(M);
+}
+
+// Buckets padded to the size of the largest one, an empty key ends a bucket.
+template <typename TPair, std::size_t N, std::size_t M, bool HasFingerprints>
+class PaddedBuckets {
+public:
+  constexpr auto begin() const { return _pairs.begin(); }
+
+  constexpr auto end() const { return _pairs.end(); }
+
+  void prefetch(std::size_t index, std::size_t) const { CTM_PREFETCH(&_pairs[index]); }
+
+  template <typename U>
+  constexpr TPair const* find(std::size_t index, std::size_t, U const& key) const {
+    for (auto ptr = _pairs[index].begin(), end_ptr = ptr + N; ptr != end_ptr; ++ptr) {
+      if (!ptr->first)
+        return nullptr;
+      if (ptr->first == key)
+        return ptr;
+    }
+    return nullptr;
+  }
+
+  constexpr std::size_t occupancy(std::size_t index) const {
+    std::size_t count = 0;
+    while (count != N && _pairs[index][count].first)
+      ++count;
+    return count;
+  }
+
+  // Slots `find` reads in bucket `index` to return `pair`, a miss also reads the empty
+  // slot that ends the bucket.
+  constexpr std::size_t probeLength(std::size_t index,
+                                    std::size_t,
+                                    TPair const* pair) const {
+    if (pair)
+      return static_cast<std::size_t>(pair - _pairs[index].begin()) + 1;
+    auto const count = occupancy(index);
+    return count != N ? count + 1 : N;
+  }
+
+  template <typename TStats>
+  constexpr void addStats(TStats& stats) const {
+    addBucketStats<M>(*this, stats);
+  }
+
+  template <typename TSpec>
+  static constexpr PaddedBuckets make(TSpec const& spec) {
+    PaddedBuckets buckets{};
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (spec.nonuniquenesses[i])
+        continue;
+      for (auto ptr = buckets._pairs[spec.bucketIndexes[i]].begin(), end_ptr = ptr + N;
+           ptr != end_ptr;
+           ++ptr) {
+        if (ptr->first)
+          continue;
+        ptr->first = spec.dataPairs[i].first;
+        assignTuples(ptr->second, spec.dataPairs[i].second);
+        break;
       }
     }
+    return buckets;
   }
-  std::size_t element_count = 0;
-  for (std::size_t i = 0; i < nonuniquenesses.size(); ++i) {
-    if (!nonuniquenesses[i])
-      ++element_count;
+
+private:
+  constexpr PaddedBuckets() : _pairs{} {}
+
+  Array<Array<TPair, N>, M> _pairs;
+};
+
+// Buckets that also keep the fingerprint of every slot in a separate array.  A lookup
+// scans the fingerprints of its bucket and reads a key only when the fingerprint
+// matches, so most misses never touch the keys.
+template <typename TPair, std::size_t N, std::size_t M>
+class PaddedBuckets<TPair, N, M, true> {
+public:
+  constexpr auto begin() const { return _pairs.begin(); }
+
+  constexpr auto end() const { return _pairs.end(); }
+
+  void prefetch(std::size_t index, std::size_t) const {
+    CTM_PREFETCH(&_fingerprints[index]);
+    CTM_PREFETCH(&_pairs[index]);
   }
-  std::size_t current_bucket_count
-    = static_cast<std::size_t>(element_count / load_factor);
-  std::size_t last_improving_bucket_count = current_bucket_count;
-  std::size_t current_max_bucket_size = 0;
-  std::size_t last_improving_max_bucket_size = std::numeric_limits<std::size_t>::max();
-  while (true) {
-    current_max_bucket_size = 0;
-    for (std::size_t i = 0; i < bucket_indexes.size(); ++i) {
-      if (nonuniquenesses[i])
+
+  template <typename U>
+  constexpr TPair const* find(std::size_t index, std::size_t hash, U const& key) const {
+    auto const fingerprint = makeFingerprint(hash);
+    auto const fingerprints = _fingerprints[index].begin();
+    for (std::size_t i = 0; i != N && fingerprints[i] != 0; ++i) {
+      if (fingerprints[i] == fingerprint && _pairs[index][i].first == key)
+        return &_pairs[index][i];
+    }
+    return nullptr;
+  }
+
+  constexpr std::size_t occupancy(std::size_t index) const {
+    std::size_t count = 0;
+    while (count != N && _fingerprints[index][count] != 0)
+      ++count;
+    return count;
+  }
+
+  constexpr std::size_t probeLength(std::size_t index,
+                                    std::size_t,
+                                    TPair const* pair) const {
+    if (pair)
+      return static_cast<std::size_t>(pair - _pairs[index].begin()) + 1;
+    auto const count = occupancy(index);
+    return count != N ? count + 1 : N;
+  }
+
+  template <typename TStats>
+  constexpr void addStats(TStats& stats) const {
+    addBucketStats<M>(*this, stats);
+  }
+
+  template <typename TSpec>
+  static constexpr PaddedBuckets make(TSpec const& spec) {
+    PaddedBuckets buckets{};
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (spec.nonuniquenesses[i])
         continue;
-      std::size_t current_bucket_size = 1;
-      std::size_t current_bucket_index = bucket_indexes[i] % current_bucket_count;
-      for (std::size_t j = i + 1; j < bucket_indexes.size(); ++j) {
-        if (!nonuniquenesses[j]
-            && (bucket_indexes[j] % current_bucket_count) == current_bucket_index)
-          ++current_bucket_size;
+      auto const index = spec.bucketIndexes[i];
+      std::size_t slot = 0;
+      while (buckets._fingerprints[index][slot] != 0)
+        ++slot;
+      buckets._fingerprints[index][slot] = makeFingerprint(spec.hashes[i]);
+      buckets._pairs[index][slot].first = spec.dataPairs[i].first;
+      assignTuples(buckets._pairs[index][slot].second, spec.dataPairs[i].second);
+    }
+    return buckets;
+  }
+
+private:
+  constexpr PaddedBuckets() : _fingerprints{}, _pairs{} {}
+
+  Array<Array<std::size_t, N>, M> _fingerprints;
+  Array<Array<TPair, N>, M> _pairs;
+};
+
+// Smallest unsigned type that holds offsets up to `N`.
+template <std::size_t N>
+using OffsetType = typename std::conditional<
+  (N <= std::numeric_limits<std::uint8_t>::max()),
+  std::uint8_t,
+  typename std::conditional<(N <= std::numeric_limits<std::uint16_t>::max()),
+                            std::uint16_t,
+                            typename std::conditional<(N <= std::numeric_limits<
+                                                              std::uint32_t>::max()),
+                                                      std::uint32_t,
+                                                      std::size_t>::type>::type>::type;
+
+// Positions of the unique pairs of a spec sorted by bucket, in the order of the spec
+// within a bucket.  Fills the `M + 1` offsets of the first pair of every bucket.
+template <std::size_t M, typename TSpec, typename TOffset>
+constexpr Array<std::size_t, TSpec::pairCount>
+makeBucketPositions(TSpec const& spec, Array<TOffset, M + 1>& offsets) {
+  Array<std::size_t, M + 1> cursors{};
+  for (std::size_t i = 0; i < TSpec::pairCount; ++i) {
+    if (!spec.nonuniquenesses[i])
+      ++cursors[spec.bucketIndexes[i] + 1];
+  }
+  for (std::size_t i = 0; i < M; ++i) {
+    cursors[i + 1] += cursors[i];
+    offsets[i + 1] = static_cast<TOffset>(cursors[i + 1]);
+  }
+  Array<std::size_t, TSpec::pairCount> positions{};
+  for (std::size_t i = 0; i < TSpec::pairCount; ++i) {
+    if (!spec.nonuniquenesses[i])
+      positions[i] = cursors[spec.bucketIndexes[i]]++;
+  }
+  return positions;
+}
+
+// Compressed sparse row layout: all pairs sorted by bucket in one dense array, plus
+// `M + 1` offsets of the first pair of every bucket.  Takes memory proportional to the
+// number of elements instead of `M * N`.
+template <typename TPair, std::size_t M, std::size_t C, bool HasFingerprints>
+class CompactBuckets {
+public:
+  constexpr auto begin() const { return _pairs.begin(); }
+
+  constexpr auto end() const { return _pairs.end(); }
+
+  // Only the offsets, the pairs depend on them.
+  void prefetch(std::size_t index, std::size_t) const { CTM_PREFETCH(&_offsets[index]); }
+
+  template <typename U>
+  constexpr TPair const* find(std::size_t index, std::size_t, U const& key) const {
+    for (auto ptr = _pairs.begin() + _offsets[index],
+              end_ptr = _pairs.begin() + _offsets[index + 1];
+         ptr != end_ptr;
+         ++ptr) {
+      if (ptr->first == key)
+        return ptr;
+    }
+    return nullptr;
+  }
+
+  constexpr std::size_t occupancy(std::size_t index) const {
+    return _offsets[index + 1] - _offsets[index];
+  }
+
+  // Slots `find` reads in bucket `index` to return `pair`, all of them for a miss.
+  constexpr std::size_t probeLength(std::size_t index,
+                                    std::size_t,
+                                    TPair const* pair) const {
+    return pair ? static_cast<std::size_t>(pair - _pairs.begin()) - _offsets[index] + 1
+                : occupancy(index);
+  }
+
+  template <typename TStats>
+  constexpr void addStats(TStats& stats) const {
+    addBucketStats<M>(*this, stats);
+  }
+
+  template <typename TSpec>
+  static constexpr CompactBuckets make(TSpec const& spec) {
+    CompactBuckets buckets{};
+    auto const positions = makeBucketPositions<M>(spec, buckets._offsets);
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (spec.nonuniquenesses[i])
+        continue;
+      auto& pair = buckets._pairs[positions[i]];
+      pair.first = spec.dataPairs[i].first;
+      assignTuples(pair.second, spec.dataPairs[i].second);
+    }
+    return buckets;
+  }
+
+private:
+  constexpr CompactBuckets() : _offsets{}, _pairs{} {}
+
+  Array<OffsetType<C>, M + 1> _offsets;
+  Array<TPair, C> _pairs;
+};
+
+template <typename TPair, std::size_t M, std::size_t C>
+class CompactBuckets<TPair, M, C, true> {
+public:
+  constexpr auto begin() const { return _pairs.begin(); }
+
+  constexpr auto end() const { return _pairs.end(); }
+
+  void prefetch(std::size_t index, std::size_t) const { CTM_PREFETCH(&_offsets[index]); }
+
+  template <typename U>
+  constexpr TPair const* find(std::size_t index, std::size_t hash, U const& key) const {
+    auto const fingerprint = makeFingerprint(hash);
+    for (std::size_t i = _offsets[index], end = _offsets[index + 1]; i != end; ++i) {
+      if (_fingerprints[i] == fingerprint && _pairs[i].first == key)
+        return &_pairs[i];
+    }
+    return nullptr;
+  }
+
+  constexpr std::size_t occupancy(std::size_t index) const {
+    return _offsets[index + 1] - _offsets[index];
+  }
+
+  constexpr std::size_t probeLength(std::size_t index,
+                                    std::size_t,
+                                    TPair const* pair) const {
+    return pair ? static_cast<std::size_t>(pair - _pairs.begin()) - _offsets[index] + 1
+                : occupancy(index);
+  }
+
+  template <typename TStats>
+  constexpr void addStats(TStats& stats) const {
+    addBucketStats<M>(*this, stats);
+  }
+
+  template <typename TSpec>
+  static constexpr CompactBuckets make(TSpec const& spec) {
+    CompactBuckets buckets{};
+    auto const positions = makeBucketPositions<M>(spec, buckets._offsets);
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (spec.nonuniquenesses[i])
+        continue;
+      auto const slot = positions[i];
+      buckets._fingerprints[slot] = makeFingerprint(spec.hashes[i]);
+      buckets._pairs[slot].first = spec.dataPairs[i].first;
+      assignTuples(buckets._pairs[slot].second, spec.dataPairs[i].second);
+    }
+    return buckets;
+  }
+
+private:
+  constexpr CompactBuckets() : _offsets{}, _fingerprints{}, _pairs{} {}
+
+  Array<OffsetType<C>, M + 1> _offsets;
+  Array<std::size_t, C> _fingerprints;
+  Array<TPair, C> _pairs;
+};
+
+// Slots of a group of GroupBuckets, the control bytes one SSE2 compare matches.
+constexpr std::size_t groupWidth = 16;
+
+// Fewest groups that hold `count` keys within CTM_HASH_MAP_GROUP_MAX_LOAD_PERCENT.
+constexpr std::size_t makeGroupCount(std::size_t count) {
+  auto const slot_count = CTM_HASH_MAP_GROUP_MAX_LOAD_PERCENT * groupWidth;
+  auto const group_count = (count * 100 + slot_count - 1) / slot_count;
+  return group_count ? group_count : 1;
+}
+
+// Open addressing over groups of 16 slots, in the style of SwissTable.  Every slot has a
+// control byte, zero when the slot is empty, otherwise the high bit and 7 bits of the key
+// hash.  A lookup matches the 16 control bytes of the group picked by the hash at once,
+// with SSE2 when not evaluated at compile time, and goes on to the next group only when
+// a key of the map walked past the group, as in F14, so most misses read one group even
+// at a high load.  The builder records the longest walk, which bounds all lookups.
+template <typename TPair, std::size_t C>
+class GroupBuckets {
+  static_assert(CTM_HASH_MAP_GROUP_MAX_LOAD_PERCENT > 0
+                  && CTM_HASH_MAP_GROUP_MAX_LOAD_PERCENT <= 100,
+                "CTM_HASH_MAP_GROUP_MAX_LOAD_PERCENT is out of range");
+
+public:
+  constexpr auto begin() const { return _pairs.begin(); }
+
+  constexpr auto end() const { return _pairs.end(); }
+
+  void prefetch(std::size_t, std::size_t hash) const {
+    auto const first = homeGroup(internal::mixHash(hash)) * groupWidth;
+    CTM_PREFETCH(&_controls[first]);
+    CTM_PREFETCH(&_pairs[first]);
+  }
+
+  template <typename U>
+  constexpr TPair const* find(std::size_t, std::size_t hash, U const& key) const {
+    auto const mixed_hash = internal::mixHash(hash);
+    auto const control = makeControl(mixed_hash);
+    auto group = homeGroup(mixed_hash);
+    for (std::size_t i = 0; i != _maxProbeLength; ++i) {
+      auto const pair = findInGroup(group * groupWidth, control, key);
+      if (pair || !_overflows[group])
+        return pair;
+      group = nextGroup(group);
+    }
+    return nullptr;
+  }
+
+  // Keys in group `index`.
+  constexpr std::size_t occupancy(std::size_t index) const {
+    std::size_t count = 0;
+    for (std::size_t i = index * groupWidth; i != (index + 1) * groupWidth; ++i)
+      count += _controls[i] != 0;
+    return count;
+  }
+
+  // Groups `find` reads to return `pair`.
+  constexpr std::size_t probeLength(std::size_t,
+                                    std::size_t hash,
+                                    TPair const* pair) const {
+    auto const home_group = homeGroup(internal::mixHash(hash));
+    if (!pair)
+      return missProbeLength(home_group);
+    auto const group = static_cast<std::size_t>(pair - _pairs.begin()) / groupWidth;
+    return (group + groupCount - home_group) % groupCount + 1;
+  }
+
+  template <typename TStats>
+  constexpr void addStats(TStats& stats) const {
+    std::size_t miss_probe_count = 0;
+    for (std::size_t i = 0; i < groupCount; ++i) {
+      ++stats.occupancyHistogram[occupancy(i)];
+      miss_probe_count += missProbeLength(i);
+    }
+    stats.averageHitProbeLength
+      = C ? static_cast<double>(_hitProbeCount) / static_cast<double>(C) : 0.0;
+    stats.maxHitProbeLength = _maxProbeLength;
+    stats.averageMissProbeLength
+      = static_cast<double>(miss_probe_count) / static_cast<double>(groupCount);
+  }
+
+  template <typename TSpec>
+  static constexpr GroupBuckets make(TSpec const& spec) {
+    GroupBuckets buckets{};
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (spec.nonuniquenesses[i])
+        continue;
+      auto const mixed_hash = internal::mixHash(spec.hashes[i]);
+      auto group = homeGroup(mixed_hash);
+      std::size_t probe_length = 1;
+      auto slot = group * groupWidth;
+      while (buckets._controls[slot] != 0) {
+        if (++slot % groupWidth != 0)
+          continue;
+        buckets._overflows[group] = true;
+        group = nextGroup(group);
+        slot = group * groupWidth;
+        ++probe_length;
       }
-      if (current_bucket_size > current_max_bucket_size)
-        current_max_bucket_size = current_bucket_size;
+      buckets._controls[slot] = makeControl(mixed_hash);
+      buckets._pairs[slot].first = spec.dataPairs[i].first;
+      assignTuples(buckets._pairs[slot].second, spec.dataPairs[i].second);
+      buckets._hitProbeCount += probe_length;
+      if (buckets._maxProbeLength < probe_length)
+        buckets._maxProbeLength = probe_length;
     }
-    if (current_max_bucket_size < last_improving_max_bucket_size) {
-      last_improving_bucket_count = current_bucket_count;
-      last_improving_max_bucket_size = current_max_bucket_size;
+    return buckets;
+  }
+
+private:
+  static constexpr std::size_t groupCount = makeGroupCount(C);
+
+  constexpr GroupBuckets()
+    : _maxProbeLength{}, _hitProbeCount{}, _overflows{}, _controls{}, _pairs{} {}
+
+  // The group comes from the high bits of the mixed hash, the control byte from the low
+  // ones.
+  static constexpr std::size_t homeGroup(std::size_t mixed_hash) {
+    return internal::multiplyHigh(mixed_hash, groupCount);
+  }
+
+  static constexpr std::uint8_t makeControl(std::size_t mixed_hash) {
+    return static_cast<std::uint8_t>(0x80 | (mixed_hash & 0x7f));
+  }
+
+  static constexpr std::size_t nextGroup(std::size_t group) {
+    return group + 1 != groupCount ? group + 1 : 0;
+  }
+
+  // Looks for `key` among the slots of the group at `first` whose control is `control`.
+  template <typename U>
+  constexpr TPair const* findInGroup(std::size_t first,
+                                     std::uint8_t control,
+                                     U const& key) const {
+#if CTM_HAS_BUILTIN_IS_CONSTANT_EVALUATED && defined(__SSE2__)
+    if (!__builtin_is_constant_evaluated()) {
+      auto const controls
+        = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&_controls[first]));
+      auto matches = static_cast<unsigned>(_mm_movemask_epi8(
+        _mm_cmpeq_epi8(controls, _mm_set1_epi8(static_cast<char>(control)))));
+      for (; matches != 0; matches &= matches - 1) {
+        auto const slot = first + static_cast<std::size_t>(__builtin_ctz(matches));
+        auto const& pair = _pairs[slot];
+        if (pair.first == key)
+          return &pair;
+      }
+      return nullptr;
     }
-    if (current_max_bucket_size <= 1) {
-      break;
+#endif
+    for (auto i = first; i != first + groupWidth; ++i) {
+      if (_controls[i] == control && _pairs[i].first == key)
+        return &_pairs[i];
     }
-    ++current_bucket_count;
-    if ((float)element_count / current_bucket_count < min_load_factor) {
-      break;
+    return nullptr;
+  }
+
+  constexpr std::size_t missProbeLength(std::size_t group) const {
+    for (std::size_t i = 0; i != _maxProbeLength; ++i) {
+      if (!_overflows[group])
+        return i + 1;
+      group = nextGroup(group);
     }
+    return _maxProbeLength;
   }
+
+  std::size_t _maxProbeLength;
+  std::size_t _hitProbeCount;
+  // Whether a key walked past the group to a later one.
+  Array<bool, groupCount> _overflows;
+  Array<std::uint8_t, groupCount * groupWidth> _controls;
+  Array<TPair, groupCount * groupWidth> _pairs;
+};
+
+// Largest occupancy of a bucket of `TBuckets`, `N` for the buckets of a spec.
+template <typename TBuckets, std::size_t N>
+struct MaxOccupancy : std::integral_constant<std::size_t, N> {};
+
+template <typename TPair, std::size_t C, std::size_t N>
+struct MaxOccupancy<GroupBuckets<TPair, C>, N>
+  : std::integral_constant<std::size_t, groupWidth> {};
+
+// Number of buckets of `TBuckets`, `M` for the buckets of a spec, the groups of
+// GroupBuckets.
+template <typename TBuckets, std::size_t M>
+struct BucketCount : std::integral_constant<std::size_t, M> {};
+
+template <typename TPair, std::size_t C, std::size_t M>
+struct BucketCount<GroupBuckets<TPair, C>, M>
+  : std::integral_constant<std::size_t, makeGroupCount(C)> {};
+
+// Whether `TBuckets` look a key up in the bucket the reduction of its hash picks, the
+// groups of GroupBuckets pick theirs from the hash alone.
+template <typename TBuckets>
+struct HasBucketIndexes : std::true_type {};
+
+template <typename TPair, std::size_t C>
+struct HasBucketIndexes<GroupBuckets<TPair, C>> : std::false_type {};
+
+template <typename TReduction, typename TBytesHash, typename... TArgs>
+constexpr auto makeGroupHashMapSpecImpl(TArgs&&... args) {
+  using tuple_type = typename Internal::TupleHeadTypeProvider<TArgs...>::type;
+  using tuple_pair_converter_type = Internal::TupleToPairConversion<tuple_type>;
+  using pair_type = typename tuple_pair_converter_type::PairType;
+  Array<pair_type, sizeof...(args)> const data_pairs{
+    {tuple_pair_converter_type::makePairFromTuple(args)...}};
+  Array<std::size_t, sizeof...(args)> hashes{};
+  Array<std::size_t, sizeof...(args)> bucket_indexes{};
+  Array<bool, sizeof...(args)> nonuniquenesses{};
+  for (std::size_t i = 0; i < hashes.size(); ++i) {
+    hashes[i] = KeyHash<TBytesHash>()(data_pairs[i].first);
+  }
+  std::size_t const element_count
+    = markNonuniquenesses(data_pairs, hashes, nonuniquenesses);
+  // The buckets of the spec stay valid for the other storages, only unsearched.
+  auto const group_count = makeGroupCount(element_count);
   for (std::size_t i = 0; i < bucket_indexes.size(); ++i) {
     if (!nonuniquenesses[i])
-      bucket_indexes[i] %= last_improving_bucket_count;
-  }
-  return HashMapSpec<pair_type, sizeof...(TArgs)>{last_improving_max_bucket_size,
-                                                  last_improving_bucket_count,
-                                                  element_count,
-                                                  data_pairs,
-                                                  bucket_indexes,
-                                                  nonuniquenesses};
+      bucket_indexes[i] = TReduction::reduce(hashes[i], group_count);
+  }
+  return HashMapSpec<pair_type, sizeof...(TArgs), TReduction, TBytesHash>{
+    maxBucketSize<TReduction>(hashes, nonuniquenesses, group_count),
+    group_count,
+    element_count,
+    0,
+    data_pairs,
+    bucket_indexes,
+    nonuniquenesses,
+    hashes};
 }
+
+// Filter that lets every key through.
+struct NoKeyFilter {
+  template <typename U>
+  constexpr bool mayContain(U const&) const noexcept {
+    return true;
+  }
+
+  template <typename TSpec>
+  static constexpr NoKeyFilter make(TSpec const&) {
+    return NoKeyFilter{};
+  }
+};
+
+// Filter of keys that cannot be in a map, checked before the key is hashed.  Keys of
+// other types than strings and integers are all let through.
+template <typename TKey, typename = void>
+struct KeyFilter : NoKeyFilter {
+  template <typename TSpec>
+  static constexpr KeyFilter make(TSpec const&) {
+    return KeyFilter{};
+  }
+};
+
+// Integer keys outside of the range of the keys of a map.
+template <typename TKey>
+struct KeyFilter<TKey, typename std::enable_if<std::is_integral<TKey>::value>::type> {
+  constexpr bool mayContain(TKey key) const noexcept {
+    return !(key < minKey) && !(maxKey < key);
+  }
+
+  template <typename TSpec>
+  static constexpr KeyFilter make(TSpec const& spec) {
+    KeyFilter filter{std::numeric_limits<TKey>::max(), std::numeric_limits<TKey>::min()};
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      auto const key = spec.dataPairs[i].first;
+      if (key < filter.minKey)
+        filter.minKey = key;
+      if (filter.maxKey < key)
+        filter.maxKey = key;
+    }
+    return filter;
+  }
+
+  TKey minKey;
+  TKey maxKey;
+};
+
+// String keys whose length or first or last character does not occur in a map.  Keys
+// of 63 characters and longer share one length bit.
+template <>
+struct KeyFilter<String> {
+  constexpr bool mayContain(String const& key) const noexcept {
+    auto const size = key.size();
+    if (!(lengths & (std::uint64_t(1) << (size < 63 ? size : 63))))
+      return false;
+    if (size == 0)
+      return true;
+    auto const first = static_cast<unsigned char>(key.chars()[0]);
+    auto const last = static_cast<unsigned char>(key.chars()[size - 1]);
+    return (firsts[first >> 6] & (std::uint64_t(1) << (first & 63)))
+           && (lasts[last >> 6] & (std::uint64_t(1) << (last & 63)));
+  }
+
+  template <typename TSpec>
+  static constexpr KeyFilter make(TSpec const& spec) {
+    KeyFilter filter{0, {}, {}};
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      auto const& key = spec.dataPairs[i].first;
+      auto const size = key.size();
+      filter.lengths |= std::uint64_t(1) << (size < 63 ? size : 63);
+      if (size == 0)
+        continue;
+      auto const first = static_cast<unsigned char>(key.chars()[0]);
+      auto const last = static_cast<unsigned char>(key.chars()[size - 1]);
+      filter.firsts[first >> 6] |= std::uint64_t(1) << (first & 63);
+      filter.lasts[last >> 6] |= std::uint64_t(1) << (last & 63);
+    }
+    return filter;
+  }
+
+  std::uint64_t lengths;
+  Array<std::uint64_t, 4> firsts;
+  Array<std::uint64_t, 4> lasts;
+};
 }
 
-template <typename... TArgs,
+template <typename TReduction = ModuloReduction,
+          typename TBytesHash = BytesHash,
+          typename... TArgs,
           typename = typename std::enable_if<std::is_floating_point<
             typename Internal::TupleHeadTypeProvider<TArgs...>::type>::value>::type>
 constexpr static auto makeHashMapSpec(TArgs&&... args) {
-  return Internal::makeHashMapSpecImpl(std::forward<TArgs>(args)...);
+  return Internal::makeHashMapSpecImpl<TReduction, TBytesHash>(
+    std::forward<TArgs>(args)...);
 }
 
-template <typename... TArgs,
+template <typename TReduction = ModuloReduction,
+          typename TBytesHash = BytesHash,
+          typename... TArgs,
           typename std::enable_if<
             !std::is_floating_point<
               typename Internal::TupleHeadTypeProvider<TArgs...>::type>::value,
             int>::type
           = 0>
 constexpr static auto makeHashMapSpec(TArgs&&... args) {
-  return Internal::makeHashMapSpecImpl(1.0, 0.5, std::forward<TArgs>(args)...);
+  Internal::checkDefaultSpecWork<TReduction, sizeof...(TArgs)>();
+  return Internal::makeHashMapSpecImpl<TReduction, TBytesHash>(
+    1.0, 0.5, std::forward<TArgs>(args)...);
+}
+
+// Spec for GroupStorage, which places the keys by their hashes alone: the keys are hashed
+// and deduplicated as by `makeHashMapSpec`, but no bucket count or seed is searched.  The
+// bucket count is the number of groups and the seed is zero.
+template <typename TReduction = ModuloReduction,
+          typename TBytesHash = BytesHash,
+          typename... TArgs>
+constexpr static auto makeGroupHashMapSpec(TArgs&&... args) {
+  return Internal::makeGroupHashMapSpecImpl<TReduction, TBytesHash>(
+    std::forward<TArgs>(args)...);
+}
+
+// Upper bound of the work of `makeHashMapSpec` for `key_count` keys, in keys and table
+// slots visited.  It grows with the key count up to the search budgets, then the searches
+// try fewer bucket counts, so a header can check it in a `static_assert` long before the
+// compiler runs out of constant evaluation steps.  `tests/compile_bench.py` measures the
+// steps of gcc and clang per unit of work.
+template <typename TReduction = ModuloReduction>
+constexpr std::size_t hashMapSpecWork(std::size_t key_count,
+                                      double load_factor = 1.0,
+                                      double min_load_factor = 0.5) {
+  return Internal::specWork<TReduction>(key_count, load_factor, min_load_factor);
+}
+
+// Storage policies of HashMap.
+
+// Every bucket padded to the size of the largest one, iteration yields buckets.
+struct PaddedStorage {
+  template <typename TPair,
+            std::size_t N,
+            std::size_t M,
+            std::size_t C,
+            bool HasFingerprints>
+  using Buckets = Internal::PaddedBuckets<TPair, N, M, HasFingerprints>;
+};
+
+// Pairs packed by bucket with an offsets array, iteration yields pairs.
+struct CompactStorage {
+  template <typename TPair,
+            std::size_t N,
+            std::size_t M,
+            std::size_t C,
+            bool HasFingerprints>
+  using Buckets = Internal::CompactBuckets<TPair, M, C, HasFingerprints>;
+};
+
+// Open addressing over groups of 16 slots at a load factor of up to
+// CTM_HASH_MAP_GROUP_MAX_LOAD_PERCENT, 75% by default, a lookup matches the 7-bit
+// fingerprints of a whole group at once.  The groups ignore the bucket count and the
+// seed of the spec, `makeGroupHashMapSpec` builds one without searching them.  Iteration
+// yields slots, empty ones hold default pairs.
+struct GroupStorage {
+  template <typename TPair,
+            std::size_t N,
+            std::size_t M,
+            std::size_t C,
+            bool HasFingerprints>
+  using Buckets = Internal::GroupBuckets<TPair, C>;
+};
+
+// Prefilter policies of HashMap.
+
+// Every lookup hashes its key.
+struct NoPrefilter {
+  template <typename TKey>
+  using Filter = Internal::NoKeyFilter;
+};
+
+// Lookups of string keys check their length and their first and last characters, lookups
+// of integer keys check the range of the keys, before the key is hashed.
+struct KeyPrefilter {
+  template <typename TKey>
+  using Filter = Internal::KeyFilter<TKey>;
+};
+
+// Layout of a HashMap with up to `N` keys per bucket, see `HashMap::stats`.  A probe is
+// one slot a lookup reads: its fingerprint, or its key for keys without fingerprints.
+// With GroupStorage the buckets are the groups and a probe reads a whole group.
+template <std::size_t N>
+struct HashMapStats {
+  // Number of buckets with `i` keys at index `i`.
+  Array<std::size_t, N + 1> occupancyHistogram;
+  std::size_t emptyBucketCount;
+  // Probes of a lookup of every key of the map.
+  double averageHitProbeLength;
+  std::size_t maxHitProbeLength;
+  // Probes of a lookup of a key that is not in the map, averaged over the buckets.
+  double averageMissProbeLength;
+  // Size of the map and of its keys and values.
+  std::size_t byteCount;
+  std::size_t payloadByteCount;
+  char const* reduction;
+  // Only string keys are hashed with the bytes hash.
+  char const* bytesHash;
+  std::size_t seed;
+};
+
+// Lookup counters of one call site, in LookupSite.hpp.
+class LookupSite;
+
+namespace Internal {
+// `T` as a type that depends on `U`, so that a template can name an incomplete `T`
+// that is completed by the time it is instantiated.
+template <typename T, typename U>
+struct DependentType {
+  using type = T;
+};
 }
 
-template <typename TSpec, std::size_t N, std::size_t M, std::size_t C>
-class HashMap {
+template <typename TSpec,
+          std::size_t N,
+          std::size_t M,
+          std::size_t C,
+          typename TStorage = PaddedStorage,
+          typename TPrefilter = NoPrefilter>
+class HashMap : private TPrefilter::template Filter<typename TSpec::KeyType> {
 public:
   using KeyType = typename TSpec::KeyType;
   using ValueType = typename TSpec::ValueType;
   using PairType = typename TSpec::PairType;
+  using HashedKeyType = HashedKey<KeyType, typename TSpec::KeyHash>;
+  // LookupSite, complete only where LookupSite.hpp is included.
+  using LookupSiteType = typename Internal::DependentType<LookupSite, TSpec>::type;
 
   constexpr auto begin() const { return _buckets.begin(); }
 
@@ -329,21 +1551,94 @@ public:
 
   constexpr std::size_t bucketSize() const { return N; };
 
-  constexpr std::size_t bucketCount() const { return M; };
+  constexpr std::size_t bucketCount() const {
+    return Internal::BucketCount<Buckets, M>::value;
+  };
 
   constexpr std::size_t size() const { return C; };
 
   template <typename U>
   constexpr ValueType find(U const& key) const noexcept {
-    for (auto ptr = _buckets[Hash<U>()(key) % M].begin(), end_ptr = ptr + N;
-         ptr != end_ptr;
-         ++ptr) {
-      if (!ptr->first)
-        return ValueType{};
-      if (ptr->first == key)
-        return ptr->second;
+    auto const pair = findPair(key);
+    return pair ? pair->second : ValueType{};
+  }
+
+  // Looks up a string key that does not have to be terminated by a null character.
+  constexpr ValueType find(char const* chars, std::size_t size) const noexcept {
+    return find(String(chars, size));
+  }
+
+  // Stored pair of a key, nullptr when the map does not have the key.
+  template <typename U>
+  constexpr PairType const* findPair(U const& key) const noexcept {
+    return findKey(Internal::LookupKey<KeyType>::make(key));
+  }
+
+  // Looks up a key hashed by the caller, the bytes of the key are not hashed again.
+  constexpr PairType const* findPair(HashedKeyType const& key) const noexcept {
+    if (!Filter::mayContain(key.key()))
+      return nullptr;
+    return findHashedKey(key.key(), Internal::seedHash(key.hash(), _seed));
+  }
+
+  // Stored value of a key without a copy, nullptr when the map does not have the key.
+  template <typename U>
+  constexpr ValueType const* findPtr(U const& key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? &pair->second : nullptr;
+  }
+
+  template <typename U>
+  constexpr bool contains(U const& key) const noexcept {
+    return findPair(key) != nullptr;
+  }
+
+  // Throws std::out_of_range when the map does not have the key.
+  template <typename U>
+  constexpr ValueType const& at(U const& key) const {
+    auto const pair = findPair(key);
+    if (!pair)
+      throw std::out_of_range("ctm::HashMap::at: no such key");
+    return pair->second;
+  }
+
+  // False when the prefilter rules the key out, true when the key may be in the map.
+  template <typename U>
+  constexpr bool mayContain(U const& key) const noexcept {
+    return Filter::mayContain(Internal::LookupKey<KeyType>::make(key));
+  }
+
+  // Looks up `count` keys and writes their values to `values`.  Keys are hashed and their
+  // buckets prefetched a batch at a time, so the cache misses of a batch overlap.  Every
+  // key is converted, hashed and reduced once.
+  template <typename U>
+  void findBatch(U const* keys, std::size_t count, ValueType* values) const noexcept {
+    using LookupKeyType = typename std::decay<decltype(
+      Internal::LookupKey<KeyType>::make(std::declval<U const&>()))>::type;
+    LookupKeyType lookup_keys[CTM_HASH_MAP_BATCH_SIZE] = {};
+    std::size_t hashes[CTM_HASH_MAP_BATCH_SIZE] = {};
+    std::size_t indexes[CTM_HASH_MAP_BATCH_SIZE] = {};
+    bool may_contains[CTM_HASH_MAP_BATCH_SIZE] = {};
+    for (std::size_t first = 0; first < count; first += CTM_HASH_MAP_BATCH_SIZE) {
+      auto const batch_size = count - first < CTM_HASH_MAP_BATCH_SIZE
+                                ? count - first
+                                : CTM_HASH_MAP_BATCH_SIZE;
+      for (std::size_t i = 0; i < batch_size; ++i) {
+        lookup_keys[i] = Internal::LookupKey<KeyType>::make(keys[first + i]);
+        may_contains[i] = Filter::mayContain(lookup_keys[i]);
+        if (!may_contains[i])
+          continue;
+        hashes[i] = hashKey(lookup_keys[i]);
+        indexes[i] = bucketIndex(hashes[i]);
+        _buckets.prefetch(indexes[i], hashes[i]);
+      }
+      for (std::size_t i = 0; i < batch_size; ++i) {
+        auto const pair = may_contains[i]
+                            ? _buckets.find(indexes[i], hashes[i], lookup_keys[i])
+                            : nullptr;
+        values[first + i] = pair ? pair->second : ValueType{};
+      }
     }
-    return ValueType{};
   }
 
   template <typename U>
@@ -351,27 +1646,103 @@ public:
     return find(key);
   }
 
-  static constexpr HashMap make(TSpec const& spec) {
-    Array<Array<PairType, N>, M> array{};
-    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
-      if (spec.nonuniquenesses[i])
-        continue;
-      for (auto ptr = array[spec.bucketIndexes[i]].begin(), end_ptr = ptr + N;
-           ptr != end_ptr;
-           ++ptr) {
-        if (ptr->first)
-          continue;
-        ptr->first = spec.dataPairs[i].first;
-        Internal::assignTuples(ptr->second, spec.dataPairs[i].second);
-        break;
-      }
+  // Lookups that count themselves in `site`, a key the prefilter rules out is a miss
+  // without probes.  They need LookupSite.hpp.
+  template <typename U>
+  ValueType find(U const& key, LookupSiteType& site) const noexcept {
+    auto const pair = findPair(key, site);
+    return pair ? pair->second : ValueType{};
+  }
+
+  template <typename U>
+  PairType const* findPair(U const& key, LookupSiteType& site) const noexcept {
+    auto const& lookup_key = Internal::LookupKey<KeyType>::make(key);
+    if (!Filter::mayContain(lookup_key)) {
+      site.record(false, 0);
+      return nullptr;
+    }
+    return findCountedKey(lookup_key, hashKey(lookup_key), site);
+  }
+
+  PairType const* findPair(HashedKeyType const& key,
+                           LookupSiteType& site) const noexcept {
+    if (!Filter::mayContain(key.key())) {
+      site.record(false, 0);
+      return nullptr;
     }
-    return HashMap{array};
+    return findCountedKey(key.key(), Internal::seedHash(key.hash(), _seed), site);
+  }
+
+  constexpr auto stats() const {
+    HashMapStats<Internal::MaxOccupancy<Buckets, N>::value> stats{{},
+                          0,
+                          0.0,
+                          0,
+                          0.0,
+                          sizeof(HashMap),
+                          C * sizeof(PairType),
+                          Internal::PolicyName<typename TSpec::Reduction>::get(),
+                          Internal::PolicyName<typename TSpec::BytesHash>::get(),
+                          _seed};
+    _buckets.addStats(stats);
+    stats.emptyBucketCount = stats.occupancyHistogram[0];
+    return stats;
+  }
+
+  static constexpr HashMap make(TSpec const& spec) {
+    return HashMap{Filter::make(spec), spec.seed, Buckets::make(spec)};
   }
 
 private:
-  constexpr HashMap(Array<Array<PairType, N>, M> const& data) : _buckets(data){};
+  template <typename U>
+  constexpr std::size_t hashKey(U const& key) const noexcept {
+    return Internal::seedHash(typename TSpec::KeyHash()(key), _seed);
+  }
+
+  template <typename U>
+  constexpr PairType const* findKey(U const& key) const noexcept {
+    if (!Filter::mayContain(key))
+      return nullptr;
+    return findHashedKey(key, hashKey(key));
+  }
+
+  // Bucket of a hash, GroupBuckets ignore it, so their lookups skip the reduction.
+  constexpr static std::size_t bucketIndex(std::size_t hash) noexcept {
+    return bucketIndex(hash, Internal::HasBucketIndexes<Buckets>());
+  }
+
+  constexpr static std::size_t bucketIndex(std::size_t hash, std::true_type) noexcept {
+    return TSpec::Reduction::reduce(hash, M);
+  }
+
+  constexpr static std::size_t bucketIndex(std::size_t, std::false_type) noexcept {
+    return 0;
+  }
+
+  template <typename U>
+  constexpr PairType const* findHashedKey(U const& key, std::size_t hash) const noexcept {
+    return _buckets.find(bucketIndex(hash), hash, key);
+  }
+
+  template <typename U>
+  PairType const* findCountedKey(U const& key,
+                                 std::size_t hash,
+                                 LookupSiteType& site) const noexcept {
+    auto const index = bucketIndex(hash);
+    auto const pair = _buckets.find(index, hash, key);
+    site.record(pair != nullptr, _buckets.probeLength(index, hash, pair));
+    return pair;
+  }
+
+  using Buckets = typename TStorage::
+    template Buckets<PairType, N, M, C, Internal::HasFingerprints<KeyType>::value>;
+
+  using Filter = typename TPrefilter::template Filter<KeyType>;
+
+  constexpr HashMap(Filter const& filter, std::size_t seed, Buckets const& buckets)
+    : Filter(filter), _seed(seed), _buckets(buckets){};
 
-  Array<Array<PairType, N>, M> _buckets;
+  std::size_t _seed;
+  Buckets _buckets;
 };
 }
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "HashMap.hpp"
+
+namespace ctm {
+template <typename TReduction = ModuloReduction,
+          typename TBytesHash = BytesHash,
+          typename... TArgs>
+constexpr static auto
+makeHashSetSpec(double load_factor, double min_load_factor, TArgs&&... keys) {
+  return Internal::makeHashMapSpecImpl<TReduction, TBytesHash>(
+    load_factor, min_load_factor, std::make_tuple(std::forward<TArgs>(keys))...);
+}
+
+// Spec of a set is the spec of a map from its keys to empty tuples, built by the same
+// bucket count and seed search.
+template <typename TReduction = ModuloReduction,
+          typename TBytesHash = BytesHash,
+          typename... TArgs,
+          typename std::enable_if<
+            !std::is_floating_point<
+              typename Internal::TupleHeadTypeProvider<TArgs...>::type>::value,
+            int>::type
+          = 0>
+constexpr static auto makeHashSetSpec(TArgs&&... keys) {
+  Internal::checkDefaultSpecWork<TReduction, sizeof...(TArgs)>();
+  return Internal::makeHashMapSpecImpl<TReduction, TBytesHash>(
+    1.0, 0.5, std::make_tuple(std::forward<TArgs>(keys))...);
+}
+
+// Keys only, packed by bucket with an offsets array like `CompactStorage`, for membership
+// tests without value storage.
+template <typename TSpec,
+          std::size_t N,
+          std::size_t M,
+          std::size_t C,
+          typename TPrefilter = NoPrefilter>
+class HashSet : private TPrefilter::template Filter<typename TSpec::KeyType> {
+public:
+  using KeyType = typename TSpec::KeyType;
+  using HashedKeyType = HashedKey<KeyType, typename TSpec::KeyHash>;
+
+  constexpr auto begin() const { return _keys.begin(); }
+
+  constexpr auto end() const { return _keys.end(); }
+
+  constexpr std::size_t bucketSize() const { return N; };
+
+  constexpr std::size_t bucketCount() const { return M; };
+
+  constexpr std::size_t size() const { return C; };
+
+  template <typename U>
+  constexpr bool contains(U const& key) const noexcept {
+    return containsKey(Internal::LookupKey<KeyType>::make(key));
+  }
+
+  // Looks up a string key that does not have to be terminated by a null character.
+  constexpr bool contains(char const* chars, std::size_t size) const noexcept {
+    return containsKey(String(chars, size));
+  }
+
+  // Looks up a key hashed by the caller, the bytes of the key are not hashed again.
+  constexpr bool contains(HashedKeyType const& key) const noexcept {
+    return Filter::mayContain(key.key())
+           && containsHashedKey(key.key(), Internal::seedHash(key.hash(), _seed));
+  }
+
+  // False when the prefilter rules the key out, true when the key may be in the set.
+  template <typename U>
+  constexpr bool mayContain(U const& key) const noexcept {
+    return Filter::mayContain(Internal::LookupKey<KeyType>::make(key));
+  }
+
+  static constexpr HashSet make(TSpec const& spec) {
+    HashSet set{Filter::make(spec), spec.seed};
+    auto const positions = Internal::makeBucketPositions<M>(spec, set._offsets);
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (!spec.nonuniquenesses[i])
+        set._keys[positions[i]] = spec.dataPairs[i].first;
+    }
+    return set;
+  }
+
+private:
+  template <typename U>
+  constexpr bool containsKey(U const& key) const noexcept {
+    return Filter::mayContain(key)
+           && containsHashedKey(
+             key, Internal::seedHash(typename TSpec::KeyHash()(key), _seed));
+  }
+
+  template <typename U>
+  constexpr bool containsHashedKey(U const& key, std::size_t hash) const noexcept {
+    auto const index = TSpec::Reduction::reduce(hash, M);
+    for (auto ptr = _keys.begin() + _offsets[index],
+              end_ptr = _keys.begin() + _offsets[index + 1];
+         ptr != end_ptr;
+         ++ptr) {
+      if (*ptr == key)
+        return true;
+    }
+    return false;
+  }
+
+  using Filter = typename TPrefilter::template Filter<KeyType>;
+
+  constexpr HashSet(Filter const& filter, std::size_t seed)
+    : Filter(filter), _seed(seed), _offsets{}, _keys{} {};
+
+  std::size_t _seed;
+  Array<Internal::OffsetType<C>, M + 1> _offsets;
+  Array<KeyType, C> _keys;
+};
+}
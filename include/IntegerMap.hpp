@@ -0,0 +1,302 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "HashMap.hpp"
+
+// Largest ratio of the key range to the number of keys that still gets a direct-indexed
+// table.
+#ifndef CTM_INTEGER_MAP_DENSE_SPREAD_DEFAULT
+#define CTM_INTEGER_MAP_DENSE_SPREAD_DEFAULT 2.0
+#endif
+
+// Largest ratio of the slot count to the number of keys for multiply-shift hashing.
+#ifndef CTM_INTEGER_MAP_MAX_SLOT_FACTOR
+#define CTM_INTEGER_MAP_MAX_SLOT_FACTOR 16
+#endif
+
+// Number of multipliers tried for every slot count.
+#ifndef CTM_INTEGER_MAP_MAX_MULTIPLIER_COUNT
+#define CTM_INTEGER_MAP_MAX_MULTIPLIER_COUNT 256
+#endif
+
+namespace ctm {
+template <typename T, std::size_t N>
+struct IntegerMapSpec {
+  using KeyType = typename T::first_type;
+  using ValueType = typename T::second_type;
+  using PairType = T;
+
+  bool isDense;
+  std::size_t slotCount;
+  std::size_t elementCount;
+  KeyType minKey;
+  std::size_t multiplier;
+  Array<PairType, N> dataPairs;
+  Array<bool, N> nonuniquenesses;
+};
+
+namespace Internal {
+// Slot of a key in a multiply-shift table of `2^bits` slots: the upper `bits` bits of
+// the product of the key with an odd multiplier.
+constexpr std::size_t
+multiplyShiftSlot(std::size_t key, std::size_t multiplier, std::size_t bits) {
+  return (key * multiplier) >> (std::numeric_limits<std::size_t>::digits - bits);
+}
+
+constexpr std::size_t bitCount(std::size_t power_of_two) {
+  std::size_t result = 0;
+  while (power_of_two >>= 1)
+    ++result;
+  return result;
+}
+
+template <typename... TArgs>
+constexpr auto makeIntegerMapSpecImpl(double dense_spread, TArgs&&... args) {
+  using tuple_type = typename Internal::TupleHeadTypeProvider<TArgs...>::type;
+  using tuple_pair_converter_type = Internal::TupleToPairConversion<tuple_type>;
+  using pair_type = typename tuple_pair_converter_type::PairType;
+  using key_type = typename tuple_pair_converter_type::KeyType;
+  static_assert(std::is_integral<key_type>::value, "Keys must be integers");
+  constexpr std::size_t count = sizeof...(TArgs);
+
+  Array<pair_type, count> const data_pairs{
+    {tuple_pair_converter_type::makePairFromTuple(args)...}};
+  Array<std::size_t, count> keys{};
+  Array<bool, count> nonuniquenesses{};
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    keys[i] = static_cast<std::size_t>(data_pairs[i].first);
+  std::size_t const element_count
+    = markNonuniquenesses(data_pairs, keys, nonuniquenesses);
+
+  key_type min_key = data_pairs[0].first;
+  key_type max_key = data_pairs[0].first;
+  for (std::size_t i = 1; i < data_pairs.size(); ++i) {
+    if (data_pairs[i].first < min_key)
+      min_key = data_pairs[i].first;
+    if (max_key < data_pairs[i].first)
+      max_key = data_pairs[i].first;
+  }
+  // The range is computed modulo the size of std::size_t, so it is exact for the keys of
+  // any sign.
+  auto const range
+    = static_cast<std::size_t>(max_key) - static_cast<std::size_t>(min_key);
+  if (range < static_cast<std::size_t>(element_count * dense_spread)) {
+    return IntegerMapSpec<pair_type, count>{
+      true, range + 1, element_count, min_key, 0, data_pairs, nonuniquenesses};
+  }
+
+  constexpr auto max_slot_count
+    = CTM_INTEGER_MAP_MAX_SLOT_FACTOR * probeTableSize(count) / 2;
+  // Slots taken by an attempt are stamped with its number, so the table is never
+  // cleared.
+  Array<std::size_t, max_slot_count> stamps{};
+  std::size_t stamp = 0;
+  for (std::size_t slot_count = probeTableSize(element_count / 2);
+       slot_count <= max_slot_count;
+       slot_count <<= 1) {
+    auto const bits = bitCount(slot_count);
+    for (std::size_t i = 1; i <= CTM_INTEGER_MAP_MAX_MULTIPLIER_COUNT; ++i) {
+      auto const multiplier = makeSeed(i) | 1;
+      ++stamp;
+      std::size_t j = 0;
+      for (; j < keys.size(); ++j) {
+        if (nonuniquenesses[j])
+          continue;
+        auto& slot_stamp = stamps[multiplyShiftSlot(keys[j], multiplier, bits)];
+        if (slot_stamp == stamp)
+          break;
+        slot_stamp = stamp;
+      }
+      if (j == keys.size()) {
+        return IntegerMapSpec<pair_type, count>{
+          false, slot_count, element_count, min_key, multiplier, data_pairs,
+          nonuniquenesses};
+      }
+    }
+  }
+  return IntegerMapSpec<pair_type, count>{
+    false, 0, element_count, min_key, 0, data_pairs, nonuniquenesses};
+}
+}
+
+template <typename... TArgs,
+          typename = typename std::enable_if<std::is_floating_point<
+            typename Internal::TupleHeadTypeProvider<TArgs...>::type>::value>::type>
+constexpr static auto makeIntegerMapSpec(TArgs&&... args) {
+  return Internal::makeIntegerMapSpecImpl(std::forward<TArgs>(args)...);
+}
+
+template <typename... TArgs,
+          typename std::enable_if<
+            !std::is_floating_point<
+              typename Internal::TupleHeadTypeProvider<TArgs...>::type>::value,
+            int>::type
+          = 0>
+constexpr static auto makeIntegerMapSpec(TArgs&&... args) {
+  return Internal::makeIntegerMapSpecImpl(CTM_INTEGER_MAP_DENSE_SPREAD_DEFAULT,
+                                          std::forward<TArgs>(args)...);
+}
+
+template <typename TSpec, bool D, std::size_t M, std::size_t C>
+class IntegerMap;
+
+// Keys in a dense range: values indexed by the distance of a key from the smallest one.
+// Missing keys hold default values, so a lookup never compares keys.  A bit per value
+// tells stored keys from missing ones for `findPtr`, `contains` and `at`, which have no
+// pairs to return.
+template <typename TSpec, std::size_t M, std::size_t C>
+class IntegerMap<TSpec, true, M, C> {
+public:
+  using KeyType = typename TSpec::KeyType;
+  using ValueType = typename TSpec::ValueType;
+  using PairType = typename TSpec::PairType;
+
+  constexpr std::size_t bucketSize() const { return 1; };
+
+  constexpr std::size_t bucketCount() const { return M; };
+
+  constexpr std::size_t size() const { return C; };
+
+  constexpr ValueType find(KeyType key) const noexcept {
+    auto const index = indexOf(key);
+    if (index < M)
+      return _values[index];
+    return ValueType{};
+  }
+
+  // Stored value of a key without a copy, nullptr when the map does not have the key.
+  constexpr ValueType const* findPtr(KeyType key) const noexcept {
+    auto const index = indexOf(key);
+    if (index < M && (_presences[index / 32] >> (index % 32) & 1))
+      return &_values[index];
+    return nullptr;
+  }
+
+  constexpr bool contains(KeyType key) const noexcept { return findPtr(key) != nullptr; }
+
+  // Throws std::out_of_range when the map does not have the key.
+  constexpr ValueType const& at(KeyType key) const {
+    auto const value = findPtr(key);
+    if (!value)
+      throw std::out_of_range("ctm::IntegerMap::at: no such key");
+    return *value;
+  }
+
+  constexpr auto operator[](KeyType key) const { return find(key); }
+
+  static constexpr IntegerMap make(TSpec const& spec) {
+    IntegerMap map{spec.minKey};
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (spec.nonuniquenesses[i])
+        continue;
+      auto const index = map.indexOf(spec.dataPairs[i].first);
+      Internal::assignTuples(map._values[index], spec.dataPairs[i].second);
+      map._presences[index / 32] |= std::uint32_t(1) << (index % 32);
+    }
+    return map;
+  }
+
+private:
+  constexpr IntegerMap(KeyType min_key) : _minKey(min_key), _values{}, _presences{} {};
+
+  constexpr std::size_t indexOf(KeyType key) const {
+    return static_cast<std::size_t>(key) - static_cast<std::size_t>(_minKey);
+  }
+
+  KeyType _minKey;
+  Array<ValueType, M> _values;
+  Array<std::uint32_t, (M + 31) / 32> _presences;
+};
+
+// Sparse keys: a perfect multiply-shift hash to a power of two slots.  Empty slots hold
+// default pairs, a lookup of a key that lands there finds the default value.  The zero
+// key always lands in the first slot and cannot be told from an empty one by its pair,
+// so a flag tells whether it is stored.
+template <typename TSpec, std::size_t M, std::size_t C>
+class IntegerMap<TSpec, false, M, C> {
+  static_assert(M != 0,
+                "No multiply-shift perfect hash has been found, use HashMap or "
+                "PerfectHashMap");
+
+public:
+  using KeyType = typename TSpec::KeyType;
+  using ValueType = typename TSpec::ValueType;
+  using PairType = typename TSpec::PairType;
+
+  constexpr auto begin() const { return _slots.begin(); }
+
+  constexpr auto end() const { return _slots.end(); }
+
+  constexpr std::size_t bucketSize() const { return 1; };
+
+  constexpr std::size_t bucketCount() const { return M; };
+
+  constexpr std::size_t size() const { return C; };
+
+  constexpr ValueType find(KeyType key) const noexcept {
+    auto const& pair = _slots[Internal::multiplyShiftSlot(
+      static_cast<std::size_t>(key), _multiplier, bits)];
+    if (pair.first == key)
+      return pair.second;
+    return ValueType{};
+  }
+
+  // Stored pair of a key, nullptr when the map does not have the key.
+  constexpr PairType const* findPair(KeyType key) const noexcept {
+    auto const& pair = _slots[Internal::multiplyShiftSlot(
+      static_cast<std::size_t>(key), _multiplier, bits)];
+    if (pair.first == key && (key != KeyType{} || _hasZeroKey))
+      return &pair;
+    return nullptr;
+  }
+
+  // Stored value of a key without a copy, nullptr when the map does not have the key.
+  constexpr ValueType const* findPtr(KeyType key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? &pair->second : nullptr;
+  }
+
+  constexpr bool contains(KeyType key) const noexcept { return findPair(key) != nullptr; }
+
+  // Throws std::out_of_range when the map does not have the key.
+  constexpr ValueType const& at(KeyType key) const {
+    auto const pair = findPair(key);
+    if (!pair)
+      throw std::out_of_range("ctm::IntegerMap::at: no such key");
+    return pair->second;
+  }
+
+  constexpr auto operator[](KeyType key) const { return find(key); }
+
+  static constexpr IntegerMap make(TSpec const& spec) {
+    IntegerMap map{spec.multiplier};
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (spec.nonuniquenesses[i])
+        continue;
+      auto& slot = map._slots[Internal::multiplyShiftSlot(
+        static_cast<std::size_t>(spec.dataPairs[i].first), spec.multiplier, bits)];
+      slot.first = spec.dataPairs[i].first;
+      Internal::assignTuples(slot.second, spec.dataPairs[i].second);
+      if (spec.dataPairs[i].first == KeyType{})
+        map._hasZeroKey = true;
+    }
+    return map;
+  }
+
+private:
+  constexpr static std::size_t bits = Internal::bitCount(M);
+
+  constexpr IntegerMap(std::size_t multiplier)
+    : _multiplier(multiplier), _hasZeroKey(false), _slots{} {};
+
+  std::size_t _multiplier;
+  bool _hasZeroKey;
+  Array<PairType, M> _slots;
+};
+}
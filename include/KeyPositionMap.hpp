@@ -0,0 +1,293 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "PerfectHashMap.hpp"
+
+// Character positions from the start and from the end of the keys the search considers.
+#ifndef CTM_KEY_POSITION_MAP_MAX_POSITION
+#define CTM_KEY_POSITION_MAP_MAX_POSITION 32
+#endif
+
+namespace ctm {
+template <typename T, std::size_t N>
+struct KeyPositionMapSpec {
+  using KeyType = typename T::first_type;
+  using ValueType = typename T::second_type;
+  using PairType = T;
+
+  std::size_t positionCount;
+  std::size_t displacementCount;
+  std::size_t slotCount;
+  std::size_t elementCount;
+  Array<int, N> positions;
+  Array<PairType, N> dataPairs;
+  Array<std::size_t, N> slotIndexes;
+  Array<bool, N> nonuniquenesses;
+  Array<std::size_t, N> displacements;
+};
+
+namespace Internal {
+// Adds the character at `position` to the hash of a key.  Non-negative positions count
+// from the start of the key, negative ones from its end, so -1 is the last character.
+// Positions outside of the key read as zero.
+constexpr std::size_t
+hashKeyPosition(std::size_t hash, char const* chars, std::size_t size, int position) {
+  auto const index = position < 0 ? size - static_cast<std::size_t>(-position)
+                                  : static_cast<std::size_t>(position);
+  auto const ch = index < size ? static_cast<unsigned char>(chars[index]) : 0;
+  return (hash ^ ch) * static_cast<std::size_t>(1099511628211ULL);
+}
+
+// Hash of the length and of the characters at `positions` of a key.
+constexpr std::size_t hashKeyPositions(char const* chars,
+                                       std::size_t size,
+                                       int const* positions,
+                                       std::size_t position_count) {
+  std::size_t hash = size;
+  for (auto end = positions + position_count; positions != end; ++positions)
+    hash = hashKeyPosition(hash, chars, size, *positions);
+  return hash;
+}
+
+// Number of distinct hashes of the unique keys.
+template <std::size_t N>
+constexpr std::size_t countDistinctHashes(Array<std::size_t, N> const& hashes,
+                                          Array<bool, N> const& nonuniquenesses) {
+  constexpr auto table_size = probeTableSize(N);
+  Array<bool, table_size> is_used{};
+  Array<std::size_t, table_size> table{};
+  std::size_t result = 0;
+  for (std::size_t i = 0; i < hashes.size(); ++i) {
+    if (nonuniquenesses[i])
+      continue;
+    auto slot = internal::mixHash(hashes[i]) & (table_size - 1);
+    while (is_used[slot] && table[slot] != hashes[i])
+      slot = (slot + 1) & (table_size - 1);
+    if (!is_used[slot]) {
+      is_used[slot] = true;
+      table[slot] = hashes[i];
+      ++result;
+    }
+  }
+  return result;
+}
+
+template <typename... TArgs>
+constexpr auto makeKeyPositionMapSpecImpl(double average_bucket_size, TArgs&&... args) {
+  using tuple_type = typename Internal::TupleHeadTypeProvider<TArgs...>::type;
+  using tuple_pair_converter_type = Internal::TupleToPairConversion<tuple_type>;
+  using pair_type = typename tuple_pair_converter_type::PairType;
+  static_assert(std::is_same<typename tuple_pair_converter_type::KeyType, String>::value,
+                "Keys must be strings");
+  constexpr std::size_t count = sizeof...(TArgs);
+
+  Array<pair_type, count> const data_pairs{
+    {tuple_pair_converter_type::makePairFromTuple(args)...}};
+  Array<std::size_t, count> hashes{};
+  Array<bool, count> nonuniquenesses{};
+  for (std::size_t i = 0; i < hashes.size(); ++i)
+    hashes[i] = data_pairs[i].first.hash();
+  std::size_t const element_count
+    = markNonuniquenesses(data_pairs, hashes, nonuniquenesses);
+
+  std::size_t max_size = 0;
+  for (std::size_t i = 0; i < data_pairs.size(); ++i) {
+    hashes[i] = data_pairs[i].first.size();
+    if (data_pairs[i].first.size() > max_size)
+      max_size = data_pairs[i].first.size();
+  }
+  if (max_size > CTM_KEY_POSITION_MAP_MAX_POSITION)
+    max_size = CTM_KEY_POSITION_MAP_MAX_POSITION;
+
+  // Greedily adds the position that tells apart the most keys, until all of them differ.
+  // Every pair of distinct keys differs in their lengths or at some position, so each
+  // step makes progress while the positions are not exhausted.
+  Array<int, count> positions{};
+  std::size_t position_count = 0;
+  auto distinct_count = countDistinctHashes(hashes, nonuniquenesses);
+  while (distinct_count < element_count && position_count < count) {
+    int best_position = 0;
+    std::size_t best_distinct_count = distinct_count;
+    for (int position = -static_cast<int>(max_size);
+         position < static_cast<int>(max_size);
+         ++position) {
+      Array<std::size_t, count> position_hashes{};
+      for (std::size_t i = 0; i < hashes.size(); ++i) {
+        position_hashes[i] = hashKeyPosition(hashes[i],
+                                             data_pairs[i].first.chars(),
+                                             data_pairs[i].first.size(),
+                                             position);
+      }
+      auto const current_distinct_count
+        = countDistinctHashes(position_hashes, nonuniquenesses);
+      if (current_distinct_count > best_distinct_count) {
+        best_position = position;
+        best_distinct_count = current_distinct_count;
+      }
+    }
+    if (best_distinct_count == distinct_count)
+      break;
+    positions[position_count++] = best_position;
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+      hashes[i] = hashKeyPosition(hashes[i],
+                                  data_pairs[i].first.chars(),
+                                  data_pairs[i].first.size(),
+                                  best_position);
+    }
+    distinct_count = best_distinct_count;
+  }
+
+  auto const displacement_count
+    = perfectHashDisplacementCount(element_count, average_bucket_size);
+  Array<std::size_t, count> slot_indexes{};
+  Array<std::size_t, count> displacements{};
+  std::size_t slot_count = 0;
+  if (distinct_count == element_count) {
+    slot_count = placePerfectHash(hashes,
+                                  nonuniquenesses,
+                                  element_count,
+                                  displacement_count,
+                                  slot_indexes,
+                                  displacements);
+  }
+  return KeyPositionMapSpec<pair_type, count>{position_count,
+                                              displacement_count,
+                                              slot_count,
+                                              element_count,
+                                              positions,
+                                              data_pairs,
+                                              slot_indexes,
+                                              nonuniquenesses,
+                                              displacements};
+}
+}
+
+template <typename... TArgs,
+          typename = typename std::enable_if<std::is_floating_point<
+            typename Internal::TupleHeadTypeProvider<TArgs...>::type>::value>::type>
+constexpr static auto makeKeyPositionMapSpec(TArgs&&... args) {
+  return Internal::makeKeyPositionMapSpecImpl(std::forward<TArgs>(args)...);
+}
+
+template <typename... TArgs,
+          typename std::enable_if<
+            !std::is_floating_point<
+              typename Internal::TupleHeadTypeProvider<TArgs...>::type>::value,
+            int>::type
+          = 0>
+constexpr static auto makeKeyPositionMapSpec(TArgs&&... args) {
+  return Internal::makeKeyPositionMapSpecImpl(CTM_PERFECT_HASH_MAP_BUCKET_SIZE_DEFAULT,
+                                              std::forward<TArgs>(args)...);
+}
+
+// Perfect hash of the length and of a few character positions of the keys, like gperf
+// generates.  A lookup reads only these characters before the final key compare.
+template <typename TSpec, std::size_t P, std::size_t D, std::size_t M, std::size_t C>
+class KeyPositionMap : private Internal::PerfectHashOccupancy<M, C> {
+  static_assert(M != 0,
+                "Keys do not differ within CTM_KEY_POSITION_MAP_MAX_POSITION characters "
+                "from their start or end");
+
+public:
+  using KeyType = typename TSpec::KeyType;
+  using ValueType = typename TSpec::ValueType;
+  using PairType = typename TSpec::PairType;
+
+  constexpr auto begin() const { return _slots.begin(); }
+
+  constexpr auto end() const { return _slots.end(); }
+
+  constexpr std::size_t bucketSize() const { return 1; };
+
+  constexpr std::size_t bucketCount() const { return M; };
+
+  constexpr std::size_t positionCount() const { return P; };
+
+  constexpr int position(std::size_t index) const { return _positions[index]; };
+
+  constexpr std::size_t size() const { return C; };
+
+  template <typename U>
+  constexpr ValueType find(U const& key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? pair->second : ValueType{};
+  }
+
+  // Looks up a string key that does not have to be terminated by a null character.
+  constexpr ValueType find(char const* chars, std::size_t size) const noexcept {
+    return find(String(chars, size));
+  }
+
+  // Stored pair of a key, nullptr when the map does not have the key.
+  template <typename U>
+  constexpr PairType const* findPair(U const& key) const noexcept {
+    return findKey(Internal::LookupKey<KeyType>::make(key));
+  }
+
+  // Stored value of a key without a copy, nullptr when the map does not have the key.
+  template <typename U>
+  constexpr ValueType const* findPtr(U const& key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? &pair->second : nullptr;
+  }
+
+  template <typename U>
+  constexpr bool contains(U const& key) const noexcept {
+    return findPair(key) != nullptr;
+  }
+
+  // Throws std::out_of_range when the map does not have the key.
+  template <typename U>
+  constexpr ValueType const& at(U const& key) const {
+    auto const pair = findPair(key);
+    if (!pair)
+      throw std::out_of_range("ctm::KeyPositionMap::at: no such key");
+    return pair->second;
+  }
+
+  template <typename U>
+  constexpr auto operator[](U const& key) const {
+    return find(key);
+  }
+
+  static constexpr KeyPositionMap make(TSpec const& spec) {
+    KeyPositionMap map{};
+    for (std::size_t i = 0; i < P; ++i)
+      map._positions[i] = spec.positions[i];
+    for (std::size_t i = 0; i < D; ++i)
+      map._displacements[i] = spec.displacements[i];
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (spec.nonuniquenesses[i])
+        continue;
+      map.occupy(spec.slotIndexes[i]);
+      auto& slot = map._slots[spec.slotIndexes[i]];
+      slot.first = spec.dataPairs[i].first;
+      Internal::assignTuples(slot.second, spec.dataPairs[i].second);
+    }
+    return map;
+  }
+
+private:
+  using Occupancy = Internal::PerfectHashOccupancy<M, C>;
+
+  constexpr PairType const* findKey(String const& key) const noexcept {
+    auto const hash
+      = Internal::hashKeyPositions(key.chars(), key.size(), _positions.begin(), P);
+    auto const slot = Internal::perfectHashSlot(
+      hash, _displacements[Internal::perfectHashBucket(hash, D, M)], M);
+    if (Occupancy::isOccupied(slot) && _slots[slot].first == key)
+      return &_slots[slot];
+    return nullptr;
+  }
+
+  constexpr KeyPositionMap() : Occupancy{}, _positions{}, _displacements{}, _slots{} {};
+
+  // At least one element, arrays of zero size are not allowed.
+  Array<int, P ? P : 1> _positions;
+  Array<std::size_t, D> _displacements;
+  Array<PairType, M> _slots;
+};
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "PrefixMap.hpp"
+
+// Default number of states of a key scanner, the shallowest ones, whose transitions are
+// complete 256-entry rows.  The other states keep their trie edges only and follow
+// failure links.
+#ifndef CTM_KEY_SCANNER_DENSE_STATE_COUNT
+#define CTM_KEY_SCANNER_DENSE_STATE_COUNT 64
+#endif
+
+namespace ctm {
+// Aho-Corasick automaton of the keys of `makePrefixMapSpec`, which reports every
+// occurrence of every key in one pass over the input.  States are numbered breadth first,
+// so failure links always lead to lower states and the dense states are the shallowest.
+// An empty key never matches.  `H` is the number of dense states.
+template <typename TSpec,
+          std::size_t S,
+          std::size_t C,
+          std::size_t H = CTM_KEY_SCANNER_DENSE_STATE_COUNT>
+class KeyScanner {
+  static_assert(S > 0, "A trie has a root node");
+
+public:
+  using KeyType = typename TSpec::KeyType;
+  using ValueType = typename TSpec::ValueType;
+  using PairType = typename TSpec::PairType;
+
+  constexpr auto begin() const { return _pairs.begin(); }
+
+  constexpr auto end() const { return _pairs.end(); }
+
+  constexpr std::size_t stateCount() const { return S; };
+
+  constexpr std::size_t denseStateCount() const { return D; };
+
+  constexpr std::size_t size() const { return C; };
+
+  // Calls `callback(offset, key, value)` for every key that occurs in the characters from
+  // `ptr` to `end_ptr`, in the order of the ends of the occurrences, longer keys first
+  // among the ones that end at the same character.
+  template <typename TCallback>
+  constexpr void
+  scan(char const* ptr, char const* end_ptr, TCallback&& callback) const {
+    std::size_t state = 0;
+    for (auto const begin_ptr = ptr; ptr != end_ptr; ++ptr) {
+      state = nextState(state, static_cast<unsigned char>(*ptr));
+      auto node = _pairIndexes[state] != C ? state : _outputLinks[state];
+      for (; node != 0; node = _outputLinks[node]) {
+        auto const& pair = _pairs[_pairIndexes[node]];
+        callback(static_cast<std::size_t>(ptr - begin_ptr) + 1 - pair.first.size(),
+                 pair.first,
+                 pair.second);
+      }
+    }
+  }
+
+  static constexpr KeyScanner make(TSpec const& spec) {
+    KeyScanner scanner{};
+    // The trie of `PrefixMap`, its nodes numbered breadth first are the states.
+    auto const trie = Internal::makePrefixTrie<S, C>(spec);
+    for (std::size_t i = 0; i < C; ++i) {
+      scanner._pairs[i].first = spec.sortedPairs[i].first;
+      Internal::assignTuples(scanner._pairs[i].second, spec.sortedPairs[i].second);
+    }
+    for (std::size_t state = 0; state < S; ++state) {
+      scanner._firstChildren[state] = static_cast<StateType>(trie.firstChildren[state]);
+      scanner._labels[state] = trie.labels[state];
+      scanner._pairIndexes[state]
+        = static_cast<Internal::OffsetType<C>>(trie.pairIndexes[state]);
+    }
+    scanner._firstChildren[S] = static_cast<StateType>(trie.firstChildren[S]);
+
+    // The failure link of a state is the deepest state whose key is a proper suffix of
+    // its own, the output link the next state with a pair along the failure links.
+    for (std::size_t state = 1; state < S; ++state) {
+      auto const parent = trie.parents[state];
+      std::size_t fail = 0;
+      for (auto link = scanner._fails[parent]; parent != 0; link = scanner._fails[link]) {
+        fail = scanner.childOf(link, trie.labels[state]);
+        if (fail != 0 || link == 0)
+          break;
+      }
+      scanner._fails[state] = static_cast<StateType>(fail);
+      scanner._outputLinks[state] = scanner._pairIndexes[fail] != C || fail == 0
+                                      ? scanner._fails[state]
+                                      : scanner._outputLinks[fail];
+    }
+    for (std::size_t state = 0; state < D; ++state) {
+      for (std::size_t label = 0; label < 256; ++label) {
+        auto const child = scanner.childOf(state, static_cast<unsigned char>(label));
+        scanner._denseTargets[state][label]
+          = child != 0 || state == 0
+              ? static_cast<StateType>(child)
+              : scanner._denseTargets[scanner._fails[state]][label];
+      }
+    }
+    return scanner;
+  }
+
+private:
+  using StateType = Internal::OffsetType<S>;
+
+  constexpr static std::size_t D = S < H ? S : H;
+  static_assert(D > 0, "The root state is dense");
+
+  constexpr std::size_t nextState(std::size_t state, unsigned char label) const noexcept {
+    while (state >= D) {
+      auto const child = childOf(state, label);
+      if (child != 0)
+        return child;
+      state = _fails[state];
+    }
+    return _denseTargets[state][label];
+  }
+
+  // Trie child of a state on a character, 0 when there is none.
+  constexpr std::size_t childOf(std::size_t state, unsigned char label) const noexcept {
+    for (std::size_t child = _firstChildren[state], end_child = _firstChildren[state + 1];
+         child != end_child && !(label < _labels[child]);
+         ++child) {
+      if (_labels[child] == label)
+        return child;
+    }
+    return 0;
+  }
+
+  constexpr KeyScanner()
+    : _denseTargets{}, _firstChildren{}, _labels{}, _fails{}, _outputLinks{},
+      _pairIndexes{}, _pairs{} {};
+
+  // The root is state 0, no transition other than a failure leads to it, so 0 also stands
+  // for a missing child and for the end of the output links.
+  Array<Array<StateType, 256>, D> _denseTargets;
+  // Trie children of a state, consecutive states, and the character of the edge from
+  // the parent of a state.
+  Array<StateType, S + 1> _firstChildren;
+  Array<unsigned char, S> _labels;
+  Array<StateType, S> _fails;
+  Array<StateType, S> _outputLinks;
+  // Index of the pair of the key that ends at a state, `C` for none.
+  Array<Internal::OffsetType<C>, S> _pairIndexes;
+  Array<PairType, C> _pairs;
+};
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace ctm {
+// Lookup counters of one call site, see `CTM_HASH_MAP_FIND`.  Sites link themselves into
+// one global list when they are constructed, so they must have static storage duration.
+// The counters are relaxed atomics.
+class LookupSite {
+public:
+  LookupSite(char const* file, int line) noexcept
+    : _file(file), _line(line), _next(head().load(std::memory_order_relaxed)) {
+    while (!head().compare_exchange_weak(_next, this, std::memory_order_release))
+      ;
+  }
+
+  LookupSite(LookupSite const&) = delete;
+
+  LookupSite& operator=(LookupSite const&) = delete;
+
+  // Most recently constructed site, nullptr when there is none.
+  static LookupSite const* first() noexcept {
+    return head().load(std::memory_order_acquire);
+  }
+
+  LookupSite const* next() const noexcept { return _next; }
+
+  char const* file() const noexcept { return _file; }
+
+  int line() const noexcept { return _line; }
+
+  std::size_t lookupCount() const noexcept { return hitCount() + missCount(); }
+
+  std::size_t hitCount() const noexcept { return _hits.load(std::memory_order_relaxed); }
+
+  std::size_t missCount() const noexcept {
+    return _misses.load(std::memory_order_relaxed);
+  }
+
+  std::size_t probeCount() const noexcept {
+    return _probes.load(std::memory_order_relaxed);
+  }
+
+  void record(bool is_hit, std::size_t probe_count) noexcept {
+    (is_hit ? _hits : _misses).fetch_add(1, std::memory_order_relaxed);
+    _probes.fetch_add(probe_count, std::memory_order_relaxed);
+  }
+
+private:
+  static std::atomic<LookupSite*>& head() noexcept {
+    static std::atomic<LookupSite*> site{nullptr};
+    return site;
+  }
+
+  char const* _file;
+  int _line;
+  LookupSite* _next;
+  std::atomic<std::size_t> _hits{0};
+  std::atomic<std::size_t> _misses{0};
+  std::atomic<std::size_t> _probes{0};
+};
+}
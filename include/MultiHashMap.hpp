@@ -0,0 +1,126 @@
+#pragma once
+
+#include "HashMap.hpp"
+
+namespace ctm {
+// Values of one key, adjacent in memory.
+template <typename T>
+struct ValueRange {
+  constexpr T const* begin() const { return first; }
+
+  constexpr T const* end() const { return last; }
+
+  constexpr std::size_t size() const { return static_cast<std::size_t>(last - first); }
+
+  constexpr bool empty() const { return first == last; }
+
+  T const* first;
+  T const* last;
+};
+
+// Map of the spec of `makeHashMapSpec` that keeps the values of repeated keys instead of
+// dropping them.  Keys are packed by bucket behind an offsets array, each key owns a
+// range of the values, in the order of the spec.
+template <typename TSpec, std::size_t N, std::size_t M, std::size_t C>
+class MultiHashMap {
+  // Every pair of the spec is a value.
+  constexpr static std::size_t V = TSpec::pairCount;
+
+public:
+  using KeyType = typename TSpec::KeyType;
+  using ValueType = typename TSpec::ValueType;
+  using RangeType = ValueRange<ValueType>;
+  using HashedKeyType = HashedKey<KeyType, typename TSpec::KeyHash>;
+
+  constexpr auto begin() const { return _keys.begin(); }
+
+  constexpr auto end() const { return _keys.end(); }
+
+  constexpr std::size_t bucketSize() const { return N; };
+
+  constexpr std::size_t bucketCount() const { return M; };
+
+  constexpr std::size_t size() const { return C; };
+
+  constexpr std::size_t valueCount() const { return V; };
+
+  // Values of a key, an empty range when the map does not have the key.
+  template <typename U>
+  constexpr RangeType equal_range(U const& key) const noexcept {
+    return equalRangeOfKey(Internal::LookupKey<KeyType>::make(key));
+  }
+
+  // Looks up a string key that does not have to be terminated by a null character.
+  constexpr RangeType equal_range(char const* chars, std::size_t size) const noexcept {
+    return equalRangeOfKey(String(chars, size));
+  }
+
+  // Looks up a key hashed by the caller, the bytes of the key are not hashed again.
+  constexpr RangeType equal_range(HashedKeyType const& key) const noexcept {
+    return equalRangeOfHashedKey(key.key(), Internal::seedHash(key.hash(), _seed));
+  }
+
+  template <typename U>
+  constexpr std::size_t count(U const& key) const noexcept {
+    return equal_range(key).size();
+  }
+
+  template <typename U>
+  constexpr bool contains(U const& key) const noexcept {
+    return !equal_range(key).empty();
+  }
+
+  static constexpr MultiHashMap make(TSpec const& spec) {
+    MultiHashMap map{spec.seed};
+    // Position of every key in `_keys`, by the index of its first pair.
+    auto const positions = Internal::makeBucketPositions<M>(spec, map._offsets);
+    for (std::size_t i = 0; i < V; ++i) {
+      if (!spec.nonuniquenesses[i])
+        map._keys[positions[i]] = spec.dataPairs[i].first;
+    }
+    // Index of the first pair of the key of every pair.
+    Array<bool, V> nonuniquenesses{};
+    Array<std::size_t, V> owners{};
+    Internal::markNonuniquenesses(spec.dataPairs, spec.hashes, nonuniquenesses, &owners);
+    Array<std::size_t, C + 1> value_cursors{};
+    for (std::size_t i = 0; i < V; ++i)
+      ++value_cursors[positions[owners[i]] + 1];
+    for (std::size_t i = 0; i < C; ++i) {
+      value_cursors[i + 1] += value_cursors[i];
+      map._ranges[i + 1] = static_cast<Internal::OffsetType<V>>(value_cursors[i + 1]);
+    }
+    for (std::size_t i = 0; i < V; ++i) {
+      Internal::assignTuples(map._values[value_cursors[positions[owners[i]]]++],
+                             spec.dataPairs[i].second);
+    }
+    return map;
+  }
+
+private:
+  template <typename U>
+  constexpr RangeType equalRangeOfKey(U const& key) const noexcept {
+    return equalRangeOfHashedKey(
+      key, Internal::seedHash(typename TSpec::KeyHash()(key), _seed));
+  }
+
+  template <typename U>
+  constexpr RangeType equalRangeOfHashedKey(U const& key,
+                                            std::size_t hash) const noexcept {
+    auto const index = TSpec::Reduction::reduce(hash, M);
+    for (auto i = _offsets[index], end_i = _offsets[index + 1]; i != end_i; ++i) {
+      if (_keys[i] == key)
+        return RangeType{_values.begin() + _ranges[i], _values.begin() + _ranges[i + 1]};
+    }
+    return RangeType{nullptr, nullptr};
+  }
+
+  constexpr explicit MultiHashMap(std::size_t seed)
+    : _seed(seed), _offsets{}, _keys{}, _ranges{}, _values{} {};
+
+  std::size_t _seed;
+  Array<Internal::OffsetType<C>, M + 1> _offsets;
+  Array<KeyType, C> _keys;
+  Array<Internal::OffsetType<V>, C + 1> _ranges;
+  Array<ValueType, V> _values;
+};
+}
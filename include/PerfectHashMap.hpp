@@ -0,0 +1,358 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "HashMap.hpp"
+
+#ifndef CTM_PERFECT_HASH_MAP_BUCKET_SIZE_DEFAULT
+#define CTM_PERFECT_HASH_MAP_BUCKET_SIZE_DEFAULT 4.0
+#endif
+
+#ifndef CTM_PERFECT_HASH_MAP_MAX_DISPLACEMENT_STEP
+#define CTM_PERFECT_HASH_MAP_MAX_DISPLACEMENT_STEP 1024
+#endif
+
+namespace ctm {
+// Spec of a HashMap with PerfectStorage: the fields of HashMapSpec, whose buckets are
+// slots of one key each, and the displacements that pick the slots.  The hashes are not
+// seeded, the displacements already spread the keys.
+template <typename T, std::size_t N, typename TBytesHash = BytesHash>
+struct PerfectHashMapSpec {
+  using KeyType = typename T::first_type;
+  using ValueType = typename T::second_type;
+  using PairType = T;
+  // Slots are reduced modulo their count, see `Internal::perfectHashSlot`.
+  using Reduction = ModuloReduction;
+  using KeyHash = Internal::KeyHash<TBytesHash>;
+  using BytesHash = TBytesHash;
+
+  constexpr static std::size_t pairCount = N;
+
+  std::size_t maxBucketSize;
+  // Number of slots, zero when the keys cannot be placed.
+  std::size_t bucketCount;
+  std::size_t elementCount;
+  std::size_t seed;
+  std::size_t displacementCount;
+  Array<PairType, N> dataPairs;
+  // Slot of every key.
+  Array<std::size_t, N> bucketIndexes;
+  Array<bool, N> nonuniquenesses;
+  Array<std::size_t, N> hashes;
+  Array<std::size_t, N> displacements;
+};
+
+namespace Internal {
+// Hash-and-displace (CHD) addressing.  The hash of a key is scrambled into `g`, the key
+// belongs to the displacement bucket `g / M % D` and occupies the slot
+// `(mix(g + d0) % M + d1) % M`, where `d0 * M + d1` is the displacement of its bucket.
+// `d0` reshuffles all keys of a bucket together, `d1` shifts them to free slots.
+constexpr std::size_t perfectHashBucket(std::size_t hash,
+                                        std::size_t displacement_count,
+                                        std::size_t slot_count) {
+  return internal::mixHash(hash) / slot_count % displacement_count;
+}
+
+constexpr std::size_t
+perfectHashSlot(std::size_t hash, std::size_t displacement, std::size_t slot_count) {
+  return (internal::mixHash(internal::mixHash(hash) + displacement / slot_count)
+            % slot_count
+          + displacement % slot_count)
+         % slot_count;
+}
+
+constexpr std::size_t perfectHashDisplacementCount(std::size_t element_count,
+                                                   double average_bucket_size) {
+  auto bucket_size = static_cast<std::size_t>(average_bucket_size);
+  if (bucket_size == 0)
+    bucket_size = 1;
+  return (element_count + bucket_size - 1) / bucket_size;
+}
+
+// Occupied slots of a perfect hash table with `M` slots for `C` elements.  Empty slots
+// hold default keys, which a lookup of such a key must not match, so the slots are
+// marked when the table is not minimal.  A minimal table stores nothing.
+template <std::size_t M, std::size_t C>
+class PerfectHashOccupancy {
+public:
+  constexpr bool isOccupied(std::size_t slot) const { return _occupieds[slot]; }
+
+  constexpr void occupy(std::size_t slot) { _occupieds[slot] = true; }
+
+private:
+  Array<bool, M> _occupieds{};
+};
+
+template <std::size_t M>
+class PerfectHashOccupancy<M, M> {
+public:
+  constexpr bool isOccupied(std::size_t) const { return true; }
+
+  constexpr void occupy(std::size_t) {}
+};
+
+// Assigns distinct slots to the keys with the given hashes and fills the displacements
+// of `displacement_count` buckets.  Returns the number of slots, zero when the keys
+// cannot be placed.
+template <std::size_t N>
+constexpr std::size_t placePerfectHash(Array<std::size_t, N> const& hashes,
+                                       Array<bool, N> const& nonuniquenesses,
+                                       std::size_t element_count,
+                                       std::size_t displacement_count,
+                                       Array<std::size_t, N>& slot_indexes,
+                                       Array<std::size_t, N>& displacements) {
+  // Minimal table first; a few more slots are added only if some bucket cannot be
+  // placed within the displacement step limit.
+  for (std::size_t slot_count = element_count; slot_count < 2 * element_count;
+       ++slot_count) {
+    Array<std::size_t, N> buckets{};
+    for (std::size_t i = 0; i < hashes.size(); ++i)
+      buckets[i] = perfectHashBucket(hashes[i], displacement_count, slot_count);
+
+    // Group the keys by displacement bucket.
+    Array<std::size_t, N + 1> bucket_offsets{};
+    Array<std::size_t, N> bucket_keys{};
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+      if (!nonuniquenesses[i])
+        ++bucket_offsets[buckets[i] + 1];
+    }
+    for (std::size_t i = 0; i < displacement_count; ++i)
+      bucket_offsets[i + 1] += bucket_offsets[i];
+    Array<std::size_t, N + 1> bucket_cursors = bucket_offsets;
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+      if (!nonuniquenesses[i])
+        bucket_keys[bucket_cursors[buckets[i]]++] = i;
+    }
+
+    // Order the buckets by size, the largest first, as they are the hardest to place.
+    Array<std::size_t, N + 2> size_offsets{};
+    Array<std::size_t, N> bucket_order{};
+    for (std::size_t i = 0; i < displacement_count; ++i)
+      ++size_offsets[element_count - (bucket_offsets[i + 1] - bucket_offsets[i]) + 1];
+    for (std::size_t i = 0; i <= element_count; ++i)
+      size_offsets[i + 1] += size_offsets[i];
+    for (std::size_t i = 0; i < displacement_count; ++i) {
+      auto const size = bucket_offsets[i + 1] - bucket_offsets[i];
+      bucket_order[size_offsets[element_count - size]++] = i;
+    }
+
+    Array<bool, 2 * N> occupied{};
+    bool is_placed = true;
+    std::size_t free_slot = 0;
+    for (std::size_t i = 0; is_placed && i < displacement_count; ++i) {
+      auto const bucket = bucket_order[i];
+      auto const keys_begin = bucket_offsets[bucket];
+      auto const keys_end = bucket_offsets[bucket + 1];
+      displacements[bucket] = 0;
+      if (keys_begin == keys_end)
+        continue;
+      if (keys_end - keys_begin == 1) {
+        // Any free slot is reachable by the additive part of the displacement.
+        while (occupied[free_slot])
+          ++free_slot;
+        auto const key = bucket_keys[keys_begin];
+        displacements[bucket]
+          = (free_slot + slot_count - perfectHashSlot(hashes[key], 0, slot_count))
+            % slot_count;
+        slot_indexes[key] = free_slot;
+        occupied[free_slot] = true;
+        continue;
+      }
+      is_placed = false;
+      for (std::size_t d0 = 0;
+           !is_placed && d0 < CTM_PERFECT_HASH_MAP_MAX_DISPLACEMENT_STEP;
+           ++d0) {
+        // Slots of the keys relative to each other depend only on `d0`, so `d1` is
+        // searched only for the shuffles that keep the bucket keys apart.
+        auto j = keys_begin;
+        for (; j != keys_end; ++j) {
+          slot_indexes[bucket_keys[j]]
+            = perfectHashSlot(hashes[bucket_keys[j]], d0 * slot_count, slot_count);
+          auto k = keys_begin;
+          while (k != j && slot_indexes[bucket_keys[k]] != slot_indexes[bucket_keys[j]])
+            ++k;
+          if (k != j)
+            break;
+        }
+        if (j != keys_end)
+          continue;
+        for (std::size_t d1 = 0; !is_placed && d1 < slot_count; ++d1) {
+          auto k = keys_begin;
+          while (k != keys_end
+                 && !occupied[(slot_indexes[bucket_keys[k]] + d1) % slot_count])
+            ++k;
+          if (k == keys_end) {
+            for (k = keys_begin; k != keys_end; ++k) {
+              auto& slot = slot_indexes[bucket_keys[k]];
+              slot = (slot + d1) % slot_count;
+              occupied[slot] = true;
+            }
+            displacements[bucket] = d0 * slot_count + d1;
+            is_placed = true;
+          }
+        }
+      }
+    }
+    if (is_placed)
+      return slot_count;
+  }
+  // Only keys with colliding full hashes get here, no displacement can separate them.
+  return 0;
+}
+
+template <typename TBytesHash, typename... TArgs>
+constexpr auto makePerfectHashMapSpecImpl(double average_bucket_size, TArgs&&... args) {
+  using tuple_type = typename Internal::TupleHeadTypeProvider<TArgs...>::type;
+  using tuple_pair_converter_type = Internal::TupleToPairConversion<tuple_type>;
+  using pair_type = typename tuple_pair_converter_type::PairType;
+  constexpr std::size_t count = sizeof...(TArgs);
+
+  Array<pair_type, count> const data_pairs{
+    {tuple_pair_converter_type::makePairFromTuple(args)...}};
+  Array<std::size_t, count> hashes{};
+  Array<bool, count> nonuniquenesses{};
+  for (std::size_t i = 0; i < hashes.size(); ++i) {
+    hashes[i] = KeyHash<TBytesHash>()(data_pairs[i].first);
+  }
+  std::size_t const element_count
+    = markNonuniquenesses(data_pairs, hashes, nonuniquenesses);
+  auto const displacement_count
+    = perfectHashDisplacementCount(element_count, average_bucket_size);
+
+  Array<std::size_t, count> slot_indexes{};
+  Array<std::size_t, count> displacements{};
+  auto const slot_count = placePerfectHash(hashes,
+                                           nonuniquenesses,
+                                           element_count,
+                                           displacement_count,
+                                           slot_indexes,
+                                           displacements);
+  return PerfectHashMapSpec<pair_type, count, TBytesHash>{1,
+                                                          slot_count,
+                                                          element_count,
+                                                          0,
+                                                          displacement_count,
+                                                          data_pairs,
+                                                          slot_indexes,
+                                                          nonuniquenesses,
+                                                          hashes,
+                                                          displacements};
+}
+
+// Slots of a perfect hash table with `D` displacements and `M` slots for `C` keys.  The
+// slot of a key depends on its hash and on the displacement of its bucket only, so a
+// lookup ignores the bucket index of HashMap and compares one key.
+template <typename TPair, std::size_t D, std::size_t M, std::size_t C>
+class PerfectBuckets : private PerfectHashOccupancy<M, C> {
+  static_assert(M != 0,
+                "No perfect hash placement: either keys have colliding hashes, or the "
+                "displacement search gave up, raise "
+                "CTM_PERFECT_HASH_MAP_MAX_DISPLACEMENT_STEP");
+
+public:
+  constexpr auto begin() const { return _slots.begin(); }
+
+  constexpr auto end() const { return _slots.end(); }
+
+  void prefetch(std::size_t, std::size_t hash) const {
+    CTM_PREFETCH(&_displacements[perfectHashBucket(hash, D, M)]);
+  }
+
+  template <typename U>
+  constexpr TPair const* find(std::size_t, std::size_t hash, U const& key) const {
+    auto const slot = slotOf(hash);
+    if (Occupancy::isOccupied(slot) && _slots[slot].first == key)
+      return &_slots[slot];
+    return nullptr;
+  }
+
+  constexpr std::size_t occupancy(std::size_t index) const {
+    return Occupancy::isOccupied(index) ? 1 : 0;
+  }
+
+  // A lookup reads one slot, hit or miss.
+  constexpr std::size_t probeLength(std::size_t, std::size_t, TPair const*) const {
+    return 1;
+  }
+
+  template <typename TStats>
+  constexpr void addStats(TStats& stats) const {
+    addBucketStats<M>(*this, stats);
+  }
+
+  template <typename TSpec>
+  static constexpr PerfectBuckets make(TSpec const& spec) {
+    PerfectBuckets buckets{};
+    for (std::size_t i = 0; i < D; ++i)
+      buckets._displacements[i] = spec.displacements[i];
+    for (std::size_t i = 0; i < spec.dataPairs.size(); ++i) {
+      if (spec.nonuniquenesses[i])
+        continue;
+      buckets.occupy(spec.bucketIndexes[i]);
+      auto& slot = buckets._slots[spec.bucketIndexes[i]];
+      slot.first = spec.dataPairs[i].first;
+      assignTuples(slot.second, spec.dataPairs[i].second);
+    }
+    return buckets;
+  }
+
+private:
+  using Occupancy = PerfectHashOccupancy<M, C>;
+
+  constexpr std::size_t slotOf(std::size_t hash) const {
+    return perfectHashSlot(hash, _displacements[perfectHashBucket(hash, D, M)], M);
+  }
+
+  constexpr PerfectBuckets() : _displacements{}, _slots{} {}
+
+  Array<std::size_t, D> _displacements;
+  Array<TPair, M> _slots;
+};
+
+template <typename TPair, std::size_t D, std::size_t M, std::size_t C>
+struct HasBucketIndexes<PerfectBuckets<TPair, D, M, C>> : std::false_type {};
+}
+
+template <typename TBytesHash = BytesHash,
+          typename... TArgs,
+          typename = typename std::enable_if<std::is_floating_point<
+            typename Internal::TupleHeadTypeProvider<TArgs...>::type>::value>::type>
+constexpr static auto makePerfectHashMapSpec(TArgs&&... args) {
+  return Internal::makePerfectHashMapSpecImpl<TBytesHash>(std::forward<TArgs>(args)...);
+}
+
+template <typename TBytesHash = BytesHash,
+          typename... TArgs,
+          typename std::enable_if<
+            !std::is_floating_point<
+              typename Internal::TupleHeadTypeProvider<TArgs...>::type>::value,
+            int>::type
+          = 0>
+constexpr static auto makePerfectHashMapSpec(TArgs&&... args) {
+  return Internal::makePerfectHashMapSpecImpl<TBytesHash>(
+    CTM_PERFECT_HASH_MAP_BUCKET_SIZE_DEFAULT, std::forward<TArgs>(args)...);
+}
+
+// Storage policy of HashMap for the specs of `makePerfectHashMapSpec`, with the
+// `displacementCount` of the spec as `D`.  Every key has a slot of its own, a lookup
+// reads one displacement and compares one key.
+template <std::size_t D>
+struct PerfectStorage {
+  template <typename TPair,
+            std::size_t N,
+            std::size_t M,
+            std::size_t C,
+            bool HasFingerprints>
+  using Buckets = Internal::PerfectBuckets<TPair, D, M, C>;
+};
+
+// HashMap over the perfect hash table of a spec of `makePerfectHashMapSpec`.
+template <typename TSpec,
+          std::size_t D,
+          std::size_t M,
+          std::size_t C,
+          typename TPrefilter = NoPrefilter>
+using PerfectHashMap = HashMap<TSpec, 1, M, C, PerfectStorage<D>, TPrefilter>;
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "SortedMap.hpp"
+
+// Default number of nodes of a prefix map, the shallowest ones, whose children are
+// indexed by a complete 256-entry row.
+#ifndef CTM_PREFIX_MAP_DENSE_NODE_COUNT
+#define CTM_PREFIX_MAP_DENSE_NODE_COUNT 16
+#endif
+
+namespace ctm {
+// Distinct keys in ascending order and the number of nodes of their trie.
+template <typename T, std::size_t N>
+struct PrefixMapSpec {
+  using KeyType = typename T::first_type;
+  using ValueType = typename T::second_type;
+  using PairType = T;
+
+  std::size_t nodeCount;
+  std::size_t elementCount;
+  Array<PairType, N> sortedPairs;
+};
+
+namespace Internal {
+constexpr std::size_t commonPrefixSize(String const& lhs, String const& rhs) {
+  std::size_t result = 0;
+  while (result < lhs.size() && result < rhs.size()
+         && lhs.chars()[result] == rhs.chars()[result])
+    ++result;
+  return result;
+}
+
+// Trie of the `C` keys of a spec with `S` nodes, numbered breadth first: the shallowest
+// nodes come first and the children of every node are consecutive nodes, in the order of
+// their characters.  The nodes of `PrefixMap` and the states of `KeyScanner`.
+template <std::size_t S>
+struct PrefixTrie {
+  // First child of every node, the children of node `i` end at `firstChildren[i + 1]`.
+  Array<std::size_t, S + 1> firstChildren;
+  Array<std::size_t, S> parents;
+  Array<unsigned char, S> labels;
+  // Index of the sorted pair of the key that ends at a node, `C` for none.
+  Array<std::size_t, S> pairIndexes;
+};
+
+template <std::size_t S, std::size_t C, typename TSpec>
+constexpr PrefixTrie<S> makePrefixTrie(TSpec const& spec) {
+  // Nodes in the order the sorted keys create them, so the children of a node are
+  // numbered in the order of their characters.
+  Array<std::size_t, S> parents{};
+  Array<unsigned char, S> labels{};
+  Array<std::size_t, S> depths{};
+  Array<std::size_t, S> pair_indexes{};
+  Array<std::size_t, S> path{};
+  for (std::size_t i = 0; i < S; ++i)
+    pair_indexes[i] = C;
+  std::size_t node_count = 1;
+  for (std::size_t i = 0; i < C; ++i) {
+    auto const& key = spec.sortedPairs[i].first;
+    auto depth = i ? commonPrefixSize(spec.sortedPairs[i - 1].first, key) : 0;
+    for (; depth < key.size(); ++depth) {
+      auto const node = node_count++;
+      parents[node] = path[depth];
+      labels[node] = static_cast<unsigned char>(key.chars()[depth]);
+      depths[node] = depth + 1;
+      path[depth + 1] = node;
+    }
+    pair_indexes[path[key.size()]] = i;
+  }
+
+  // Renumbers the nodes breadth first with a stable counting sort by depth.  Nodes of a
+  // depth keep their creation order, which groups the children of a node and orders the
+  // groups like their parents.
+  Array<std::size_t, S + 1> cursors{};
+  for (std::size_t node = 0; node < S; ++node)
+    ++cursors[depths[node] + 1];
+  for (std::size_t i = 0; i < S; ++i)
+    cursors[i + 1] += cursors[i];
+  Array<std::size_t, S> numbers{};
+  for (std::size_t node = 0; node < S; ++node)
+    numbers[node] = cursors[depths[node]]++;
+
+  PrefixTrie<S> trie{};
+  for (std::size_t node = 0; node < S; ++node) {
+    auto const number = numbers[node];
+    trie.parents[number] = numbers[parents[node]];
+    trie.labels[number] = labels[node];
+    trie.pairIndexes[number] = pair_indexes[node];
+    if (node != 0)
+      ++trie.firstChildren[trie.parents[number] + 1];
+  }
+  trie.firstChildren[0] = 1;
+  for (std::size_t i = 0; i < S; ++i)
+    trie.firstChildren[i + 1] += trie.firstChildren[i];
+  return trie;
+}
+
+template <typename... TArgs>
+constexpr auto makePrefixMapSpecImpl(TArgs&&... args) {
+  auto const sorted_spec = makeSortedMapSpecImpl(std::forward<TArgs>(args)...);
+  using pair_type = typename decltype(sorted_spec)::PairType;
+  static_assert(std::is_same<typename pair_type::first_type, String>::value,
+                "Keys must be strings");
+
+  // Every key adds the nodes of its characters after the prefix it shares with the key
+  // before it.
+  PrefixMapSpec<pair_type, sizeof...(TArgs)> spec{
+    1, sorted_spec.elementCount, sorted_spec.sortedPairs};
+  for (std::size_t i = 0; i < spec.elementCount; ++i) {
+    auto const& key = spec.sortedPairs[i].first;
+    spec.nodeCount
+      += key.size() - (i ? commonPrefixSize(spec.sortedPairs[i - 1].first, key) : 0);
+  }
+  return spec;
+}
+}
+
+template <typename... TArgs>
+constexpr static auto makePrefixMapSpec(TArgs&&... args) {
+  return Internal::makePrefixMapSpecImpl(std::forward<TArgs>(args)...);
+}
+
+// Trie of string keys for finding the longest key that starts an input.  Nodes are
+// numbered breadth first; the shallowest ones, where most inputs end their match, index
+// their children by character, so a step costs one load.  The other nodes find their
+// children, consecutive nodes, by their sorted characters.  `H` is the number of dense
+// nodes.
+template <typename TSpec,
+          std::size_t S,
+          std::size_t C,
+          std::size_t H = CTM_PREFIX_MAP_DENSE_NODE_COUNT>
+class PrefixMap {
+  static_assert(S > 0, "A trie has a root node");
+
+public:
+  using KeyType = typename TSpec::KeyType;
+  using ValueType = typename TSpec::ValueType;
+  using PairType = typename TSpec::PairType;
+
+  constexpr auto begin() const { return _pairs.begin(); }
+
+  constexpr auto end() const { return _pairs.end(); }
+
+  constexpr std::size_t nodeCount() const { return S; };
+
+  constexpr std::size_t denseNodeCount() const { return D; };
+
+  constexpr std::size_t size() const { return C; };
+
+  // Stored pair of the longest key that is a prefix of the characters from `ptr` to
+  // `end_ptr`, nullptr when no key is.
+  constexpr PairType const* matchPrefix(char const* ptr,
+                                        char const* end_ptr) const noexcept {
+    // The index of the last match is selected without a branch, only the end of the
+    // match is unpredictable.
+    std::size_t match = _pairIndexes[0];
+    for (std::size_t node = 0; ptr != end_ptr;) {
+      node = childOf(node, static_cast<unsigned char>(*ptr++));
+      if (node == 0)
+        break;
+      auto const index = _pairIndexes[node];
+      match = index != C ? index : match;
+    }
+    return match != C ? &_pairs[match] : nullptr;
+  }
+
+  template <typename U>
+  constexpr ValueType find(U const& key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? pair->second : ValueType{};
+  }
+
+  // Stored pair of a key, nullptr when the map does not have the key.
+  template <typename U>
+  constexpr PairType const* findPair(U const& key) const noexcept {
+    auto const& lookup_key = Internal::LookupKey<KeyType>::make(key);
+    auto const pair
+      = matchPrefix(lookup_key.chars(), lookup_key.chars() + lookup_key.size());
+    return pair && pair->first.size() == lookup_key.size() ? pair : nullptr;
+  }
+
+  // Stored value of a key without a copy, nullptr when the map does not have the key.
+  template <typename U>
+  constexpr ValueType const* findPtr(U const& key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? &pair->second : nullptr;
+  }
+
+  template <typename U>
+  constexpr bool contains(U const& key) const noexcept {
+    return findPair(key) != nullptr;
+  }
+
+  // Throws std::out_of_range when the map does not have the key.
+  template <typename U>
+  constexpr ValueType const& at(U const& key) const {
+    auto const pair = findPair(key);
+    if (!pair)
+      throw std::out_of_range("ctm::PrefixMap::at: no such key");
+    return pair->second;
+  }
+
+  template <typename U>
+  constexpr auto operator[](U const& key) const {
+    return find(key);
+  }
+
+  static constexpr PrefixMap make(TSpec const& spec) {
+    PrefixMap map{};
+    auto const trie = Internal::makePrefixTrie<S, C>(spec);
+    for (std::size_t i = 0; i < C; ++i) {
+      map._pairs[i].first = spec.sortedPairs[i].first;
+      Internal::assignTuples(map._pairs[i].second, spec.sortedPairs[i].second);
+    }
+    for (std::size_t node = 0; node < S; ++node) {
+      map._firstChildren[node] = static_cast<NodeType>(trie.firstChildren[node]);
+      map._labels[node] = trie.labels[node];
+      map._pairIndexes[node]
+        = static_cast<Internal::OffsetType<C>>(trie.pairIndexes[node]);
+      if (node != 0 && trie.parents[node] < D)
+        map._denseChildren[trie.parents[node]][trie.labels[node]]
+          = static_cast<NodeType>(node);
+    }
+    map._firstChildren[S] = static_cast<NodeType>(trie.firstChildren[S]);
+    return map;
+  }
+
+private:
+  using NodeType = Internal::OffsetType<S>;
+
+  constexpr static std::size_t D = S < H ? S : H;
+  static_assert(D > 0, "The root node is dense");
+
+  // Child of a node on a character, 0 when there is none.
+  constexpr std::size_t childOf(std::size_t node, unsigned char label) const noexcept {
+    if (node < D)
+      return _denseChildren[node][label];
+    for (std::size_t child = _firstChildren[node], end_child = _firstChildren[node + 1];
+         child != end_child && !(label < _labels[child]);
+         ++child) {
+      if (_labels[child] == label)
+        return child;
+    }
+    return 0;
+  }
+
+  constexpr PrefixMap()
+    : _denseChildren{}, _firstChildren{}, _labels{}, _pairIndexes{}, _pairs{} {};
+
+  // The root is node 0, it is no child, so 0 also stands for a missing child.
+  Array<Array<NodeType, 256>, D> _denseChildren;
+  Array<NodeType, S + 1> _firstChildren;
+  // Character of the edge from the parent of a node.
+  Array<unsigned char, S> _labels;
+  // Index of the pair of the key that ends at a node, `C` for none.
+  Array<Internal::OffsetType<C>, S> _pairIndexes;
+  Array<PairType, C> _pairs;
+};
+}
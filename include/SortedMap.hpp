@@ -0,0 +1,287 @@
+#pragma once
+
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "HashMap.hpp"
+
+namespace ctm {
+// Distinct keys in ascending order, a repeated key keeps its first value.
+template <typename T, std::size_t N>
+struct SortedMapSpec {
+  using KeyType = typename T::first_type;
+  using ValueType = typename T::second_type;
+  using PairType = T;
+
+  std::size_t elementCount;
+  Array<PairType, N> sortedPairs;
+};
+
+namespace Internal {
+// Orders indexes of pairs by key, then by position, so that the first pair of a repeated
+// key comes first.
+template <typename TPair, std::size_t N>
+constexpr bool isPairBefore(Array<TPair, N> const& pairs, std::size_t i, std::size_t j) {
+  if (pairs[i].first < pairs[j].first)
+    return true;
+  return !(pairs[j].first < pairs[i].first) && i < j;
+}
+
+template <typename TPair, std::size_t N>
+constexpr void siftDown(Array<TPair, N> const& pairs,
+                        Array<std::size_t, N>& heap,
+                        std::size_t root,
+                        std::size_t size) {
+  for (auto child = 2 * root + 1; child < size; child = 2 * root + 1) {
+    if (child + 1 < size && isPairBefore(pairs, heap[child], heap[child + 1]))
+      ++child;
+    if (!isPairBefore(pairs, heap[root], heap[child]))
+      return;
+    auto const index = heap[root];
+    heap[root] = heap[child];
+    heap[child] = index;
+    root = child;
+  }
+}
+
+// Heap sort of the indexes of pairs, which keeps the constant evaluation in O(n log n)
+// steps.
+template <typename TPair, std::size_t N>
+constexpr Array<std::size_t, N> sortPairIndexes(Array<TPair, N> const& pairs) {
+  Array<std::size_t, N> heap{};
+  for (std::size_t i = 0; i < N; ++i)
+    heap[i] = i;
+  for (auto i = N / 2; i > 0; --i)
+    siftDown(pairs, heap, i - 1, N);
+  for (auto size = N; size > 1; --size) {
+    auto const index = heap[0];
+    heap[0] = heap[size - 1];
+    heap[size - 1] = index;
+    siftDown(pairs, heap, 0, size - 1);
+  }
+  return heap;
+}
+
+template <typename... TArgs>
+constexpr auto makeSortedMapSpecImpl(TArgs&&... args) {
+  using tuple_type = typename Internal::TupleHeadTypeProvider<TArgs...>::type;
+  using tuple_pair_converter_type = Internal::TupleToPairConversion<tuple_type>;
+  using pair_type = typename tuple_pair_converter_type::PairType;
+  constexpr std::size_t count = sizeof...(TArgs);
+
+  Array<pair_type, count> const data_pairs{
+    {tuple_pair_converter_type::makePairFromTuple(args)...}};
+  auto const indexes = sortPairIndexes(data_pairs);
+  SortedMapSpec<pair_type, count> spec{0, {}};
+  for (std::size_t i = 0; i < count; ++i) {
+    auto const& pair = data_pairs[indexes[i]];
+    if (spec.elementCount != 0
+        && !(spec.sortedPairs[spec.elementCount - 1].first < pair.first))
+      continue;
+    auto& sorted_pair = spec.sortedPairs[spec.elementCount++];
+    sorted_pair.first = pair.first;
+    assignTuples(sorted_pair.second, pair.second);
+  }
+  return spec;
+}
+
+// Predicates of the search, true for the keys that come before the result.
+template <typename U>
+struct IsKeyBefore {
+  template <typename TKey>
+  constexpr bool operator()(TKey const& node_key) const {
+    return node_key < key;
+  }
+
+  U const& key;
+};
+
+template <typename U>
+struct IsKeyNotAfter {
+  template <typename TKey>
+  constexpr bool operator()(TKey const& node_key) const {
+    return !(key < node_key);
+  }
+
+  U const& key;
+};
+
+// Keys not after the prefix once cut to its length: the keys before the prefix and the
+// keys that start with it.
+struct IsPrefixNotAfter {
+  constexpr bool operator()(String const& node_key) const {
+    auto const size = node_key.size() < prefix.size() ? node_key.size() : prefix.size();
+    return !(prefix < String(node_key.chars(), size));
+  }
+
+  String const& prefix;
+};
+
+// Number of trailing one bits of a value.
+constexpr std::size_t trailingOneCount(std::size_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return ~value ? static_cast<std::size_t>(__builtin_ctzll(~value))
+                : std::numeric_limits<std::size_t>::digits;
+#else
+  std::size_t result = 0;
+  for (; value & 1; value >>= 1)
+    ++result;
+  return result;
+#endif
+}
+}
+
+template <typename... TArgs>
+constexpr static auto makeSortedMapSpec(TArgs&&... args) {
+  return Internal::makeSortedMapSpecImpl(std::forward<TArgs>(args)...);
+}
+
+// Keys in the breadth-first order of a complete binary search tree (Eytzinger layout),
+// searched without branching on the comparisons, and the pairs in ascending order for
+// iteration and ranges.  Node `k` has the children `2k` and `2k + 1`, the root is node 1.
+template <typename TSpec, std::size_t C>
+class SortedMap {
+public:
+  using KeyType = typename TSpec::KeyType;
+  using ValueType = typename TSpec::ValueType;
+  using PairType = typename TSpec::PairType;
+  using RangeType = std::pair<PairType const*, PairType const*>;
+
+  constexpr auto begin() const { return _pairs.begin(); }
+
+  constexpr auto end() const { return _pairs.end(); }
+
+  constexpr std::size_t size() const { return C; };
+
+  // First pair whose key is not less than `key`, `end()` when there is none.
+  template <typename U>
+  constexpr PairType const* lower_bound(U const& key) const noexcept {
+    auto const& lookup_key = Internal::LookupKey<KeyType>::make(key);
+    return search(Internal::IsKeyBefore<std::decay_t<decltype(lookup_key)>>{lookup_key});
+  }
+
+  // First pair whose key is greater than `key`, `end()` when there is none.
+  template <typename U>
+  constexpr PairType const* upper_bound(U const& key) const noexcept {
+    auto const& lookup_key = Internal::LookupKey<KeyType>::make(key);
+    return search(
+      Internal::IsKeyNotAfter<std::decay_t<decltype(lookup_key)>>{lookup_key});
+  }
+
+  template <typename U>
+  constexpr RangeType equal_range(U const& key) const noexcept {
+    return RangeType{lower_bound(key), upper_bound(key)};
+  }
+
+  // Pairs whose string keys start with `prefix`.
+  template <typename U>
+  constexpr RangeType prefixRange(U const& prefix) const noexcept {
+    auto const& lookup_prefix = Internal::LookupKey<KeyType>::make(prefix);
+    return RangeType{
+      search(Internal::IsKeyBefore<String>{lookup_prefix}),
+      search(Internal::IsPrefixNotAfter{lookup_prefix})};
+  }
+
+  template <typename U>
+  constexpr ValueType find(U const& key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? pair->second : ValueType{};
+  }
+
+  // Stored pair of a key, nullptr when the map does not have the key.
+  template <typename U>
+  constexpr PairType const* findPair(U const& key) const noexcept {
+    auto const& lookup_key = Internal::LookupKey<KeyType>::make(key);
+    auto const pair = lower_bound(lookup_key);
+    if (pair == _pairs.end() || lookup_key < pair->first)
+      return nullptr;
+    return pair;
+  }
+
+  // Stored value of a key without a copy, nullptr when the map does not have the key.
+  template <typename U>
+  constexpr ValueType const* findPtr(U const& key) const noexcept {
+    auto const pair = findPair(key);
+    return pair ? &pair->second : nullptr;
+  }
+
+  template <typename U>
+  constexpr bool contains(U const& key) const noexcept {
+    return findPair(key) != nullptr;
+  }
+
+  // Throws std::out_of_range when the map does not have the key.
+  template <typename U>
+  constexpr ValueType const& at(U const& key) const {
+    auto const pair = findPair(key);
+    if (!pair)
+      throw std::out_of_range("ctm::SortedMap::at: no such key");
+    return pair->second;
+  }
+
+  template <typename U>
+  constexpr auto operator[](U const& key) const {
+    return find(key);
+  }
+
+  static constexpr SortedMap make(TSpec const& spec) {
+    SortedMap map{};
+    map._ranks[0] = C;
+    for (std::size_t i = 0; i < C; ++i) {
+      map._pairs[i].first = spec.sortedPairs[i].first;
+      Internal::assignTuples(map._pairs[i].second, spec.sortedPairs[i].second);
+    }
+    map.fill(1, 0);
+    return map;
+  }
+
+private:
+  // Keys of the nodes that fit in a cache line, the search prefetches the descendants of
+  // a node that many levels down.
+  constexpr static std::size_t prefetchStride
+    = sizeof(KeyType) < 64 ? 64 / sizeof(KeyType) : 1;
+
+  // Descends from the root, going right after the keys that come before the result.  The
+  // node of the result is the last one the search went left at: the path without its
+  // trailing right turns and that left turn.
+  template <typename TPredicate>
+  constexpr PairType const* search(TPredicate const& is_before) const noexcept {
+    std::size_t node = 1;
+    while (node <= C) {
+      prefetch(node * prefetchStride);
+      node = 2 * node + static_cast<std::size_t>(is_before(_keys[node]));
+    }
+    node >>= Internal::trailingOneCount(node) + 1;
+    return _pairs.begin() + _ranks[node];
+  }
+
+  constexpr void prefetch(std::size_t node) const noexcept {
+#if CTM_HAS_BUILTIN_IS_CONSTANT_EVALUATED
+    if (!__builtin_is_constant_evaluated() && node <= C)
+      CTM_PREFETCH(&_keys[node]);
+#else
+    static_cast<void>(node);
+#endif
+  }
+
+  // Gives the nodes of the subtree of `node` the pairs from `rank` on, in order, returns
+  // the rank after them.
+  constexpr std::size_t fill(std::size_t node, std::size_t rank) {
+    if (node > C)
+      return rank;
+    rank = fill(2 * node, rank);
+    _keys[node] = _pairs[rank].first;
+    _ranks[node] = static_cast<Internal::OffsetType<C>>(rank);
+    return fill(2 * node + 1, rank + 1);
+  }
+
+  constexpr SortedMap() : _keys{}, _ranks{}, _pairs{} {};
+
+  // Node 0 stands for the end of the search past the last key.
+  Array<KeyType, C + 1> _keys;
+  Array<Internal::OffsetType<C>, C + 1> _ranks;
+  Array<PairType, C> _pairs;
+};
+}
@@ -0,0 +1,467 @@
+#include <HashMap.hpp>
+#include <IntegerMap.hpp>
+#include <KeyPositionMap.hpp>
+#include <PrefixMap.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+using namespace ctm;
+
+namespace {
+constexpr std::size_t keyCount = 64;
+
+constexpr int makeKey(std::size_t index) { return static_cast<int>(index * 7919 + 3); }
+
+template <typename TReduction, std::size_t... I>
+constexpr auto makeIntegerSpec(std::index_sequence<I...>) {
+    return makeHashMapSpec<TReduction>(std::make_tuple(makeKey(I), int(I + 1))...);
+}
+
+template <typename TReduction>
+constexpr auto makeIntegerMap() {
+    constexpr auto spec
+        = makeIntegerSpec<TReduction>(std::make_index_sequence<keyCount>());
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+template <typename TReduction, typename TPrefilter = NoPrefilter>
+constexpr auto makeStringMap() {
+    constexpr auto spec = makeHashMapSpec<TReduction>(std::make_tuple("alignas", 1),
+                                                      std::make_tuple("auto", 2),
+                                                      std::make_tuple("bool", 3),
+                                                      std::make_tuple("break", 4),
+                                                      std::make_tuple("case", 5),
+                                                      std::make_tuple("catch", 6),
+                                                      std::make_tuple("char", 7),
+                                                      std::make_tuple("class", 8),
+                                                      std::make_tuple("const", 9),
+                                                      std::make_tuple("constexpr", 10),
+                                                      std::make_tuple("continue", 11),
+                                                      std::make_tuple("default", 12),
+                                                      std::make_tuple("delete", 13),
+                                                      std::make_tuple("double", 14),
+                                                      std::make_tuple("else", 15),
+                                                      std::make_tuple("enum", 16));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   PaddedStorage,
+                   TPrefilter>::make(spec);
+}
+
+constexpr auto makeKeyPositionStringMap() {
+    constexpr auto spec = makeKeyPositionMapSpec(std::make_tuple("alignas", 1),
+                                                 std::make_tuple("auto", 2),
+                                                 std::make_tuple("bool", 3),
+                                                 std::make_tuple("break", 4),
+                                                 std::make_tuple("case", 5),
+                                                 std::make_tuple("catch", 6),
+                                                 std::make_tuple("char", 7),
+                                                 std::make_tuple("class", 8),
+                                                 std::make_tuple("const", 9),
+                                                 std::make_tuple("constexpr", 10),
+                                                 std::make_tuple("continue", 11),
+                                                 std::make_tuple("default", 12),
+                                                 std::make_tuple("delete", 13),
+                                                 std::make_tuple("double", 14),
+                                                 std::make_tuple("else", 15),
+                                                 std::make_tuple("enum", 16));
+    return KeyPositionMap<decltype(spec),
+                          spec.positionCount,
+                          spec.displacementCount,
+                          spec.slotCount,
+                          spec.elementCount>::make(spec);
+}
+
+constexpr std::size_t largeKeyCount = 8192;
+
+template <std::size_t... I>
+constexpr auto makeLargeSpec(std::index_sequence<I...>) {
+    return makeHashMapSpec(std::make_tuple(makeKey(I), int(I + 1))...);
+}
+
+constexpr auto largeSpec = makeLargeSpec(std::make_index_sequence<largeKeyCount>());
+
+constexpr auto makeLargeMap() {
+    return HashMap<decltype(largeSpec),
+                   largeSpec.maxBucketSize,
+                   largeSpec.bucketCount,
+                   largeSpec.elementCount>::make(largeSpec);
+}
+
+// The groups do not depend on the bucket count and the seed, so they are not searched.
+template <std::size_t... I>
+constexpr auto makeGroupLargeSpec(std::index_sequence<I...>) {
+    return makeGroupHashMapSpec(std::make_tuple(makeKey(I), int(I + 1))...);
+}
+
+constexpr auto groupLargeSpec
+    = makeGroupLargeSpec(std::make_index_sequence<largeKeyCount>());
+
+constexpr auto makeGroupLargeMap() {
+    return HashMap<decltype(groupLargeSpec),
+                   groupLargeSpec.maxBucketSize,
+                   groupLargeSpec.bucketCount,
+                   groupLargeSpec.elementCount,
+                   GroupStorage>::make(groupLargeSpec);
+}
+
+template <std::size_t... I>
+constexpr auto makeIntegerMapSpec(std::index_sequence<I...>) {
+    return ctm::makeIntegerMapSpec(std::make_tuple(makeKey(I), int(I + 1))...);
+}
+
+constexpr auto makeMultiplyShiftMap() {
+    constexpr auto spec = makeIntegerMapSpec(std::make_index_sequence<keyCount>());
+    return IntegerMap<decltype(spec),
+                      spec.isDense,
+                      spec.slotCount,
+                      spec.elementCount>::make(spec);
+}
+
+template <std::size_t... I>
+constexpr auto makeDenseSpec(std::index_sequence<I...>) {
+    return ctm::makeIntegerMapSpec(std::make_tuple(int(I), int(I + 1))...);
+}
+
+constexpr auto makeDenseMap() {
+    constexpr auto spec = makeDenseSpec(std::make_index_sequence<2 * keyCount>());
+    return IntegerMap<decltype(spec),
+                      spec.isDense,
+                      spec.slotCount,
+                      spec.elementCount>::make(spec);
+}
+
+template <typename TBytesHash, typename TPrefilter = NoPrefilter>
+constexpr auto makeMetricMap() {
+    constexpr auto spec = makeHashMapSpec<ModuloReduction, TBytesHash>(
+        std::make_tuple("http.server.request.duration.seconds", 1),
+        std::make_tuple("http.server.request.body.size.bytes", 2),
+        std::make_tuple("http.server.response.body.size.bytes", 3),
+        std::make_tuple("http.server.active_requests", 4),
+        std::make_tuple("http.client.request.duration.seconds", 5),
+        std::make_tuple("http.client.open_connections", 6),
+        std::make_tuple("process.runtime.jvm.memory.usage.after.last.gc", 7),
+        std::make_tuple("process.runtime.jvm.threads.count", 8),
+        std::make_tuple("system.network.dropped.packets.total", 9),
+        std::make_tuple("system.filesystem.utilization.ratio", 10));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   PaddedStorage,
+                   TPrefilter>::make(spec);
+}
+
+// The metric names of makeMetricMap, told apart by a few character positions instead
+// of a hash of all their characters.
+constexpr auto makeKeyPositionMetricMap() {
+    constexpr auto spec = makeKeyPositionMapSpec(
+        std::make_tuple("http.server.request.duration.seconds", 1),
+        std::make_tuple("http.server.request.body.size.bytes", 2),
+        std::make_tuple("http.server.response.body.size.bytes", 3),
+        std::make_tuple("http.server.active_requests", 4),
+        std::make_tuple("http.client.request.duration.seconds", 5),
+        std::make_tuple("http.client.open_connections", 6),
+        std::make_tuple("process.runtime.jvm.memory.usage.after.last.gc", 7),
+        std::make_tuple("process.runtime.jvm.threads.count", 8),
+        std::make_tuple("system.network.dropped.packets.total", 9),
+        std::make_tuple("system.filesystem.utilization.ratio", 10));
+    return KeyPositionMap<decltype(spec),
+                          spec.positionCount,
+                          spec.displacementCount,
+                          spec.slotCount,
+                          spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTokenMap() {
+    constexpr auto spec = makePrefixMapSpec(std::make_tuple("alignas", 1),
+                                            std::make_tuple("auto", 2),
+                                            std::make_tuple("bool", 3),
+                                            std::make_tuple("break", 4),
+                                            std::make_tuple("case", 5),
+                                            std::make_tuple("char", 6),
+                                            std::make_tuple("class", 7),
+                                            std::make_tuple("const", 8),
+                                            std::make_tuple("constexpr", 9),
+                                            std::make_tuple("else", 10),
+                                            std::make_tuple("for", 11),
+                                            std::make_tuple("if", 12),
+                                            std::make_tuple("int", 13),
+                                            std::make_tuple("return", 14),
+                                            std::make_tuple("while", 15),
+                                            std::make_tuple("+", 16),
+                                            std::make_tuple("++", 17),
+                                            std::make_tuple("+=", 18),
+                                            std::make_tuple("-", 19),
+                                            std::make_tuple("--", 20),
+                                            std::make_tuple("->", 21),
+                                            std::make_tuple("<", 22),
+                                            std::make_tuple("<<", 23),
+                                            std::make_tuple("<=", 24),
+                                            std::make_tuple(">", 25),
+                                            std::make_tuple(">>", 26),
+                                            std::make_tuple(">=", 27),
+                                            std::make_tuple("=", 28),
+                                            std::make_tuple("==", 29),
+                                            std::make_tuple("!=", 30),
+                                            std::make_tuple("&&", 31),
+                                            std::make_tuple("||", 32),
+                                            std::make_tuple("::", 33),
+                                            std::make_tuple("(", 34),
+                                            std::make_tuple(")", 35),
+                                            std::make_tuple("{", 36),
+                                            std::make_tuple("}", 37),
+                                            std::make_tuple(";", 38),
+                                            std::make_tuple(",", 39));
+    return PrefixMap<decltype(spec), spec.nodeCount, spec.elementCount>::make(spec);
+}
+
+char const tokenSource[]
+    = "constexpr int find(char const* chars, int size) {\n"
+      "    for (int i = 0; i < size; ++i) {\n"
+      "        if (chars[i] == '<' && i + 1 != size) return i;\n"
+      "        else if (classify(chars[i]) >= limit || counter-- <= 0) break;\n"
+      "    }\n"
+      "    return node->next ? std::min(total >> 2, width) : -1;\n"
+      "}\n";
+
+char const* const metricQueries[] = {"http.server.request.duration.seconds",
+                                     "http.server.request.body.size.bytes",
+                                     "http.server.response.body.size.bytes",
+                                     "http.server.active_requests",
+                                     "http.client.request.duration.seconds",
+                                     "http.client.open_connections",
+                                     "process.runtime.jvm.memory.usage.after.last.gc",
+                                     "process.runtime.jvm.threads.count",
+                                     "system.network.dropped.packets.total",
+                                     "system.filesystem.utilization.ratio",
+                                     "http.server.request.duration.milliseconds",
+                                     "http.client.request.body.size.bytes",
+                                     "process.runtime.jvm.memory.usage",
+                                     "system.network.io.bytes.total",
+                                     "system.cpu.utilization.ratio",
+                                     "process.cpu.time.seconds.total"};
+
+char const* const stringQueries[] = {"alignas",
+                                     "auto",
+                                     "bool",
+                                     "break",
+                                     "case",
+                                     "catch",
+                                     "char",
+                                     "class",
+                                     "const",
+                                     "constexpr",
+                                     "continue",
+                                     "default",
+                                     "delete",
+                                     "double",
+                                     "else",
+                                     "enum",
+                                     "explicit",
+                                     "export",
+                                     "extern",
+                                     "false",
+                                     "float",
+                                     "for",
+                                     "friend",
+                                     "goto",
+                                     "if",
+                                     "inline",
+                                     "int",
+                                     "long",
+                                     "mutable",
+                                     "namespace",
+                                     "new",
+                                     "noexcept"};
+
+volatile long sink;
+
+template <typename TMap, typename TKey>
+void run(char const* name, TMap const& map, TKey const* keys, std::size_t key_count) {
+    // About 25 million lookups per benchmark.
+    auto const rounds = 25600000 / key_count;
+    long sum = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (std::size_t i = 0; i < key_count; ++i)
+            sum += map.find(keys[i]);
+    }
+    auto const stop = std::chrono::steady_clock::now();
+    sink = sum;
+    auto const nanoseconds
+        = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+    std::printf("%s,%zu,%zu,%.3f\n",
+                name,
+                map.bucketCount(),
+                map.bucketSize(),
+                static_cast<double>(nanoseconds) / (rounds * key_count));
+}
+}
+
+// Tokenizes a source buffer with `matchPrefix` at every position that does not continue
+// a match, as a lexer does.
+template <typename TMap>
+void runPrefix(char const* name, TMap const& map, std::string const& text) {
+    // About 25 million bytes per benchmark.
+    auto const rounds = 25600000 / text.size();
+    long sum = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (auto ptr = text.data(), end_ptr = ptr + text.size(); ptr != end_ptr;) {
+            auto const pair = map.matchPrefix(ptr, end_ptr);
+            if (!pair) {
+                ++ptr;
+                continue;
+            }
+            sum += pair->second;
+            ptr += pair->first.size();
+        }
+    }
+    auto const stop = std::chrono::steady_clock::now();
+    sink = sum;
+    auto const nanoseconds
+        = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+    std::printf("%s,%zu,%zu,%.3f\n",
+                name,
+                map.nodeCount(),
+                map.size(),
+                static_cast<double>(nanoseconds) / (rounds * text.size()));
+}
+
+// Floor of a tokenizer loop: one table load and one branch per byte, on whether a key
+// is the byte.
+template <typename TMap>
+void runFirstByte(char const* name, TMap const& map, std::string const& text) {
+    bool is_keys[256] = {};
+    for (int i = 0; i < 256; ++i) {
+        auto const ch = static_cast<char>(i);
+        is_keys[i] = map.matchPrefix(&ch, &ch + 1) != nullptr;
+    }
+    auto const rounds = 25600000 / text.size();
+    long sum = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (auto const ch : text) {
+            if (is_keys[static_cast<unsigned char>(ch)])
+                sum += ch;
+        }
+    }
+    auto const stop = std::chrono::steady_clock::now();
+    sink = sum;
+    auto const nanoseconds
+        = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+    std::printf("%s,1,%zu,%.3f\n",
+                name,
+                map.size(),
+                static_cast<double>(nanoseconds) / (rounds * text.size()));
+}
+
+template <typename TMap, typename TKey>
+void reportRejections(char const* name,
+                      TMap const& map,
+                      TKey const* keys,
+                      std::size_t key_count) {
+    std::size_t miss_count = 0;
+    std::size_t rejection_count = 0;
+    for (std::size_t i = 0; i < key_count; ++i) {
+        if (map.find(keys[i]))
+            continue;
+        ++miss_count;
+        if (!map.mayContain(keys[i]))
+            ++rejection_count;
+    }
+    std::printf("%s,%zu,%zu,%.3f\n",
+                name,
+                miss_count,
+                rejection_count,
+                miss_count ? static_cast<double>(rejection_count) / miss_count : 0.0);
+}
+
+int main() {
+    static constexpr auto modulo_integers = makeIntegerMap<ModuloReduction>();
+    static constexpr auto mask_integers = makeIntegerMap<MaskReduction>();
+    static constexpr auto range_integers = makeIntegerMap<FastRangeReduction>();
+    static constexpr auto large_integers = makeLargeMap();
+    static constexpr auto group_large_integers = makeGroupLargeMap();
+    static constexpr auto multiply_shift_integers = makeMultiplyShiftMap();
+    static constexpr auto dense_integers = makeDenseMap();
+    static constexpr auto modulo_strings = makeStringMap<ModuloReduction>();
+    static constexpr auto mask_strings = makeStringMap<MaskReduction>();
+    static constexpr auto range_strings = makeStringMap<FastRangeReduction>();
+    static constexpr auto filtered_strings
+        = makeStringMap<ModuloReduction, KeyPrefilter>();
+    static constexpr auto filtered_metrics = makeMetricMap<WyBytesHash<>, KeyPrefilter>();
+    static constexpr auto key_position_strings = makeKeyPositionStringMap();
+    static constexpr auto fnv_metrics = makeMetricMap<FnvBytesHash<4>>();
+    static constexpr auto murmur_metrics = makeMetricMap<MurmurBytesHash<>>();
+    static constexpr auto wy_metrics = makeMetricMap<WyBytesHash<>>();
+    static constexpr auto key_position_metrics = makeKeyPositionMetricMap();
+
+    // Half of the queries hit, half miss.
+    int integer_queries[2 * keyCount] = {};
+    for (std::size_t i = 0; i < keyCount; ++i) {
+        integer_queries[2 * i] = makeKey(i);
+        integer_queries[2 * i + 1] = makeKey(i) + 1;
+    }
+    constexpr auto string_query_count = sizeof(stringQueries) / sizeof(*stringQueries);
+    constexpr auto metric_query_count = sizeof(metricQueries) / sizeof(*metricQueries);
+
+    std::printf("benchmark,bucket_count,bucket_size,ns_per_lookup\n");
+    run("int/modulo", modulo_integers, integer_queries, 2 * keyCount);
+    run("int/mask", mask_integers, integer_queries, 2 * keyCount);
+    run("int/fastrange", range_integers, integer_queries, 2 * keyCount);
+    run("int/multiplyshift", multiply_shift_integers, integer_queries, 2 * keyCount);
+    // Scattered over the whole table, half of the queries hit.
+    static int large_queries[4 * largeKeyCount] = {};
+    for (std::size_t i = 0; i < 4 * largeKeyCount; ++i) {
+        auto const index = i * 2654435761u % (2 * largeKeyCount);
+        large_queries[i] = makeKey(index / 2) + static_cast<int>(index % 2);
+    }
+    run("int/large", large_integers, large_queries, 4 * largeKeyCount);
+    run("int/large/group", group_large_integers, large_queries, 4 * largeKeyCount);
+    int dense_queries[2 * keyCount] = {};
+    for (std::size_t i = 0; i < 2 * keyCount; ++i)
+        dense_queries[i] = static_cast<int>(i);
+    run("int/dense", dense_integers, dense_queries, 2 * keyCount);
+    run("string/modulo", modulo_strings, stringQueries, string_query_count);
+    run("string/mask", mask_strings, stringQueries, string_query_count);
+    run("string/fastrange", range_strings, stringQueries, string_query_count);
+    run("string/prefilter", filtered_strings, stringQueries, string_query_count);
+    run("string/keyposition", key_position_strings, stringQueries, string_query_count);
+    // Lengths known in advance, as for tokens of a parsed buffer.
+    String sized_queries[string_query_count];
+    for (std::size_t i = 0; i < string_query_count; ++i)
+        sized_queries[i] = stringQueries[i];
+    run("string/modulo/sized", modulo_strings, sized_queries, string_query_count);
+    run("string/keyposition/sized",
+        key_position_strings,
+        sized_queries,
+        string_query_count);
+    run("metric/fnv", fnv_metrics, metricQueries, metric_query_count);
+    run("metric/murmur", murmur_metrics, metricQueries, metric_query_count);
+    run("metric/wyhash", wy_metrics, metricQueries, metric_query_count);
+    run("metric/keyposition", key_position_metrics, metricQueries, metric_query_count);
+    run("metric/wyhash/prefilter", filtered_metrics, metricQueries, metric_query_count);
+
+    static constexpr auto tokens = makeTokenMap();
+    std::string token_text;
+    while (token_text.size() < 65536)
+        token_text += tokenSource;
+    std::printf("\nprefix,node_count,key_count,ns_per_byte\n");
+    runPrefix("token", tokens, token_text);
+    runFirstByte("token/firstbyte", tokens, token_text);
+
+    std::printf("\nprefilter,misses,rejections,rejection_rate\n");
+    reportRejections("string", filtered_strings, stringQueries, string_query_count);
+    reportRejections("metric", filtered_metrics, metricQueries, metric_query_count);
+    return 0;
+}
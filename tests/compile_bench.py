@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""Compile-time cost of makeHashMapSpec.
+
+Compiles a map of N generated string keys with every compiler and prints one CSV row
+per compiler and key count: the wall time and the peak memory of the compiler, the
+`ctm::hashMapSpecWork` estimate and, with --steps, the smallest constant evaluation
+limit that still compiles (-fconstexpr-ops-limit for gcc, -fconstexpr-steps for clang),
+found by bisection.  A failed compile under the default limits has an empty time.
+
+    tests/compile_bench.py [--compilers g++,clang++] [--counts 100,1000] [--steps]
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+INCLUDE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include")
+
+SOURCE = """#include <HashMap.hpp>
+
+#include <cstdio>
+
+constexpr auto makeMap() {{
+    constexpr auto spec = ctm::makeHashMapSpec({tuples});
+    return ctm::HashMap<decltype(spec),
+                        spec.maxBucketSize,
+                        spec.bucketCount,
+                        spec.elementCount>::make(spec);
+}}
+
+int main() {{
+    static constexpr auto map = makeMap();
+    std::printf("%zu\\n", map.size() ? ctm::hashMapSpecWork({count}) : 0);
+    return 0;
+}}
+"""
+
+
+def write_source(directory, count):
+    tuple_format = 'std::make_tuple("key.{0:06d}.{1:x}", {0})'
+    tuples = ",\n        ".join(tuple_format.format(i, i * 7919) for i in range(count))
+    path = os.path.join(directory, "spec{}.cpp".format(count))
+    with open(path, "w") as source:
+        source.write(SOURCE.format(tuples=tuples, count=count))
+    return path
+
+
+def is_clang(compiler):
+    output = subprocess.run([compiler, "--version"], stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT, universal_newlines=True).stdout
+    return "clang" in output
+
+
+def compile_source(compiler, path, output, extra_flags):
+    """Returns whether the compile succeeded, its wall time and peak memory in KiB."""
+    command = [compiler, "-std=c++14", "-O2", "-I", INCLUDE_DIR, path] + extra_flags
+    command += ["-o", output] if output else ["-fsyntax-only"]
+    start = time.monotonic()
+    process = subprocess.Popen(command, stdout=subprocess.DEVNULL,
+                               stderr=subprocess.DEVNULL)
+    _, status, usage = os.wait4(process.pid, 0)
+    seconds = time.monotonic() - start
+    # ru_maxrss is in KiB on Linux and in bytes on macOS.
+    peak = usage.ru_maxrss // 1024 if sys.platform == "darwin" else usage.ru_maxrss
+    return os.WIFEXITED(status) and os.WEXITSTATUS(status) == 0, seconds, peak
+
+
+def limit_flags(clang, limit):
+    if clang:
+        return ["-fconstexpr-steps={}".format(limit)]
+    return ["-fconstexpr-ops-limit={}".format(limit), "-fconstexpr-loop-limit=2147483647"]
+
+
+def find_step_count(compiler, clang, path):
+    """Smallest limit that compiles, within 1%, or None above 2^40."""
+    low, high = 0, 1 << 16
+    while not compile_source(compiler, path, None, limit_flags(clang, high))[0]:
+        low, high = high, high * 4
+        if high > 1 << 40:
+            return None
+    while high - low > high // 100:
+        middle = (low + high) // 2
+        if compile_source(compiler, path, None, limit_flags(clang, middle))[0]:
+            high = middle
+        else:
+            low = middle
+    return high
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--compilers", default="g++,clang++")
+    parser.add_argument("--counts", default="100,300,1000,3000")
+    parser.add_argument("--steps", action="store_true",
+                        help="bisect the constant evaluation limit, compiles ~20 times")
+    arguments = parser.parse_args()
+
+    compilers = [c for c in arguments.compilers.split(",") if shutil.which(c)]
+    if not compilers:
+        sys.exit("compile_bench.py: none of {} found".format(arguments.compilers))
+    print("compiler,key_count,seconds,peak_kib,spec_work,constexpr_steps,steps_per_work")
+    with tempfile.TemporaryDirectory() as directory:
+        for count in (int(c) for c in arguments.counts.split(",")):
+            path = write_source(directory, count)
+            for compiler in compilers:
+                clang = is_clang(compiler)
+                binary = os.path.join(directory, "spec")
+                is_compiled, seconds, peak = compile_source(compiler, path, binary, [])
+                work = ""
+                if is_compiled:
+                    work = subprocess.run([binary], stdout=subprocess.PIPE,
+                                          universal_newlines=True).stdout.strip()
+                steps = None
+                if arguments.steps:
+                    steps = find_step_count(compiler, clang, path)
+                ratio = "{:.1f}".format(steps / int(work)) if steps and work else ""
+                time_text = "{:.2f}".format(seconds) if is_compiled else ""
+                print("{},{},{},{},{},{},{}".format(
+                    compiler, count, time_text, peak, work, steps or "", ratio), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,46 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#define CTM_HASH_MAP_COUNTERS
+
+#include <HashMap.hpp>
+
+#include <cassert>
+#include <string>
+
+using namespace ctm;
+
+constexpr auto makeTestMap0290() {
+    constexpr auto spec = makeHashMapSpec(std::make_tuple("alpha", 1),
+                                          std::make_tuple("beta", 2),
+                                          std::make_tuple("gamma", 3));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+// Every expansion of the macros counts in a site of its own.
+int findTwice0290(char const* key) {
+    static constexpr auto words = makeTestMap0290();
+    auto const pair = CTM_HASH_MAP_FIND_PAIR(words, key);
+    return CTM_HASH_MAP_FIND(words, std::string(key)) + (pair ? pair->second : 0);
+}
+
+void test0290() {
+    assert(findTwice0290("beta") == 4);
+    assert(findTwice0290("delta") == 0);
+    assert(findTwice0290("gamma") == 6);
+
+    std::size_t site_count = 0;
+    for (auto site = LookupSite::first(); site; site = site->next()) {
+        if (std::string(site->file()).find("counters.cpp") == std::string::npos)
+            continue;
+        ++site_count;
+        assert(site->lookupCount() == 3);
+        assert(site->hitCount() == 2 && site->missCount() == 1);
+        assert(site->probeCount() >= 2);
+    }
+    assert(site_count == 2);
+}
@@ -0,0 +1,311 @@
+// Lookup benchmark suite: ctm::HashMap against std::unordered_map, a sorted array with
+// binary search and a chain of compares, over key counts, key lengths, hit ratios, key
+// types and bytes hashes.  Prints one CSV row per measurement.
+
+#include <HashMap.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace ctm;
+
+namespace {
+constexpr std::size_t queryCount = 4096;
+constexpr double minSeconds = 0.1;
+constexpr double hitRatios[] = {1.0, 0.5, 0.0};
+
+// Keys of a table are `L` lowercase letters: the base 26 digits of the index times an
+// odd prime modulo `26^L`, which is a bijection, so all keys of a table are distinct.
+// The first `N` keys go into the maps, the next `N` ones are misses.
+template <std::size_t L>
+struct KeyChars {
+    char data[L + 1];
+};
+
+constexpr std::size_t keySpace(std::size_t length) {
+    std::size_t result = 1;
+    for (std::size_t i = 0; i < length && i < 13; ++i)
+        result *= 26;
+    return result;
+}
+
+template <std::size_t L>
+constexpr KeyChars<L> makeKeyChars(std::size_t index) {
+    KeyChars<L> chars{};
+    auto value = index * 7919 % keySpace(L);
+    for (auto i = L; i > 0; --i) {
+        chars.data[i - 1] = static_cast<char>('a' + value % 26);
+        value /= 26;
+    }
+    return chars;
+}
+
+template <std::size_t N, std::size_t L>
+struct KeyTable {
+    static constexpr Array<KeyChars<L>, 2 * N> make() {
+        Array<KeyChars<L>, 2 * N> keys{};
+        for (std::size_t i = 0; i < 2 * N; ++i)
+            keys[i] = makeKeyChars<L>(i);
+        return keys;
+    }
+
+    static constexpr String key(std::size_t index) { return String(keys[index].data, L); }
+
+    static constexpr Array<KeyChars<L>, 2 * N> keys = make();
+};
+
+template <std::size_t N, std::size_t L>
+constexpr Array<KeyChars<L>, 2 * N> KeyTable<N, L>::keys;
+
+constexpr int makeIntegerKey(std::size_t index) {
+    return static_cast<int>(index * 7919 + 3);
+}
+
+template <typename TBytesHash, std::size_t N, std::size_t L, std::size_t... I>
+constexpr auto makeStringSpec(std::index_sequence<I...>) {
+    return makeHashMapSpec<ModuloReduction, TBytesHash>(
+        std::make_tuple(KeyTable<N, L>::key(I), int(I + 1))...);
+}
+
+template <typename TBytesHash, std::size_t N, std::size_t L>
+constexpr auto makeStringMap() {
+    constexpr auto spec = makeStringSpec<TBytesHash, N, L>(std::make_index_sequence<N>());
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+template <std::size_t N, std::size_t... I>
+constexpr auto makeIntegerSpec(std::index_sequence<I...>) {
+    return makeHashMapSpec(std::make_tuple(makeIntegerKey(I), int(I + 1))...);
+}
+
+template <std::size_t N>
+constexpr auto makeIntegerMap() {
+    constexpr auto spec = makeIntegerSpec<N>(std::make_index_sequence<N>());
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+// Indexes of the queries: a hit with the probability `hit_ratio`, spread over the keys.
+std::vector<std::size_t> makeQueryIndexes(std::size_t key_count, double hit_ratio) {
+    std::vector<std::size_t> indexes(queryCount);
+    std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (auto& index : indexes) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        auto const is_hit = static_cast<double>(state >> 40) / (1 << 24) < hit_ratio;
+        index = static_cast<std::size_t>(state >> 16) % key_count;
+        if (!is_hit)
+            index += key_count;
+    }
+    return indexes;
+}
+
+volatile long sink;
+
+// Repeats the queries until `minSeconds` have passed, returns nanoseconds per lookup.
+template <typename TFind, typename TQuery>
+double measure(TFind const& find, std::vector<TQuery> const& queries) {
+    long sum = 0;
+    std::size_t lookup_count = 0;
+    double seconds = 0;
+    auto const start = std::chrono::steady_clock::now();
+    while (seconds < minSeconds) {
+        for (auto const& query : queries)
+            sum += find(query);
+        lookup_count += queries.size();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                      .count();
+    }
+    sink = sum;
+    return seconds * 1e9 / lookup_count;
+}
+
+// The same for `findBatch` over all queries at once.
+template <typename TMap, typename TQuery>
+double measureBatch(TMap const& map, std::vector<TQuery> const& queries) {
+    std::vector<typename TMap::ValueType> values(queries.size());
+    long sum = 0;
+    std::size_t lookup_count = 0;
+    double seconds = 0;
+    auto const start = std::chrono::steady_clock::now();
+    while (seconds < minSeconds) {
+        map.findBatch(queries.data(), queries.size(), values.data());
+        for (auto const value : values)
+            sum += value;
+        lookup_count += queries.size();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                      .count();
+    }
+    sink = sum;
+    return seconds * 1e9 / lookup_count;
+}
+
+struct Case {
+    std::size_t keyCount;
+    std::size_t keyLength;
+    double hitRatio;
+};
+
+void report(Case const& c,
+            char const* container,
+            char const* key_type,
+            char const* hash,
+            double ns_per_lookup) {
+    std::printf("%s,%s,%s,%zu,%zu,%.2f,%.3f,%.0f\n",
+                container,
+                key_type,
+                hash,
+                c.keyCount,
+                c.keyLength,
+                c.hitRatio,
+                ns_per_lookup,
+                1e9 / ns_per_lookup);
+}
+
+// ctm::HashMap with both bytes hashes and the baselines, for string keys.
+template <std::size_t N, std::size_t L>
+void runStrings() {
+    static constexpr auto fnv_map = makeStringMap<FnvBytesHash<4>, N, L>();
+    static constexpr auto murmur_map = makeStringMap<MurmurBytesHash<>, N, L>();
+    auto const& fnv = fnv_map;
+    auto const& murmur = murmur_map;
+    using Table = KeyTable<N, L>;
+
+    std::unordered_map<std::string, int> unordered;
+    std::vector<std::pair<String, int>> sorted;
+    std::vector<char const*> chain;
+    for (std::size_t i = 0; i < N; ++i) {
+        unordered.emplace(Table::key(i).toStdString(), int(i + 1));
+        sorted.emplace_back(Table::key(i), int(i + 1));
+        chain.push_back(Table::keys[i].data);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    for (auto const hit_ratio : hitRatios) {
+        Case const c{N, L, hit_ratio};
+        std::vector<String> sized_queries;
+        std::vector<std::string> queries;
+        for (auto const index : makeQueryIndexes(N, hit_ratio)) {
+            sized_queries.push_back(Table::key(index));
+            queries.push_back(Table::key(index).toStdString());
+        }
+        auto const find_fnv = [&](auto const& query) { return fnv.find(query); };
+        auto const find_murmur = [&](auto const& query) { return murmur.find(query); };
+        auto const find_unordered = [&](std::string const& query) {
+            auto const it = unordered.find(query);
+            return it != unordered.end() ? it->second : 0;
+        };
+        auto const find_sorted = [&](std::string const& query) {
+            String const key(query);
+            auto const it = std::lower_bound(
+                sorted.begin(), sorted.end(), key, [](auto const& pair, String const& k) {
+                    return pair.first < k;
+                });
+            return it != sorted.end() && it->first == key ? it->second : 0;
+        };
+        // A loop of strcmp calls, the code an if/strcmp chain compiles to.
+        auto const find_chain = [&](std::string const& query) {
+            for (std::size_t i = 0; i < chain.size(); ++i) {
+                if (std::strcmp(chain[i], query.c_str()) == 0)
+                    return int(i + 1);
+            }
+            return 0;
+        };
+        report(c, "ctm::HashMap", "String", "fnv", measure(find_fnv, sized_queries));
+        report(c, "ctm::HashMap", "std::string", "fnv", measure(find_fnv, queries));
+        report(c,
+               "ctm::HashMap/batch",
+               "String",
+               "fnv",
+               measureBatch(fnv, sized_queries));
+        report(c,
+               "ctm::HashMap",
+               "String",
+               "murmur",
+               measure(find_murmur, sized_queries));
+        report(c, "ctm::HashMap", "std::string", "murmur", measure(find_murmur, queries));
+        report(c,
+               "std::unordered_map",
+               "std::string",
+               "std::hash",
+               measure(find_unordered, queries));
+        report(c, "sorted_array", "std::string", "-", measure(find_sorted, queries));
+        report(c, "strcmp_chain", "std::string", "-", measure(find_chain, queries));
+    }
+}
+
+template <std::size_t N>
+void runIntegers() {
+    static constexpr auto integer_map = makeIntegerMap<N>();
+    auto const& map = integer_map;
+
+    std::unordered_map<int, int> unordered;
+    std::array<std::pair<int, int>, N> sorted{};
+    std::array<int, N> chain{};
+    for (std::size_t i = 0; i < N; ++i) {
+        unordered.emplace(makeIntegerKey(i), int(i + 1));
+        sorted[i] = std::make_pair(makeIntegerKey(i), int(i + 1));
+        chain[i] = makeIntegerKey(i);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    for (auto const hit_ratio : hitRatios) {
+        Case const c{N, 0, hit_ratio};
+        std::vector<int> queries;
+        for (auto const index : makeQueryIndexes(N, hit_ratio))
+            queries.push_back(makeIntegerKey(index));
+        auto const find_ctm = [&](int query) { return map.find(query); };
+        auto const find_unordered = [&](int query) {
+            auto const it = unordered.find(query);
+            return it != unordered.end() ? it->second : 0;
+        };
+        auto const find_sorted = [&](int query) {
+            auto const it = std::lower_bound(
+                sorted.begin(), sorted.end(), std::make_pair(query, 0));
+            return it != sorted.end() && it->first == query ? it->second : 0;
+        };
+        auto const find_chain = [&](int query) {
+            for (std::size_t i = 0; i < N; ++i) {
+                if (chain[i] == query)
+                    return int(i + 1);
+            }
+            return 0;
+        };
+        report(c, "ctm::HashMap", "int", "ctm::Hash", measure(find_ctm, queries));
+        report(c,
+               "std::unordered_map",
+               "int",
+               "std::hash",
+               measure(find_unordered, queries));
+        report(c, "sorted_array", "int", "-", measure(find_sorted, queries));
+        report(c, "if_chain", "int", "-", measure(find_chain, queries));
+    }
+}
+}
+
+int main() {
+    std::printf("container,key_type,hash,key_count,key_length,hit_ratio,ns_per_lookup,"
+                "lookups_per_second\n");
+    runStrings<8, 16>();
+    runStrings<100, 16>();
+    runStrings<1000, 4>();
+    runStrings<1000, 16>();
+    runStrings<1000, 64>();
+    runStrings<10000, 16>();
+    runIntegers<8>();
+    runIntegers<100>();
+    runIntegers<1000>();
+    runIntegers<10000>();
+    return 0;
+}
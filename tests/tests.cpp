@@ -2,11 +2,30 @@
 #undef NDEBUG
 #endif
 
+#include <FrozenHashMap.hpp>
+#include <FrozenImage.hpp>
 #include <HashMap.hpp>
+#include <HashSet.hpp>
+#include <IntegerMap.hpp>
+#include <KeyPositionMap.hpp>
+#include <KeyScanner.hpp>
+#include <LookupSite.hpp>
+#include <MultiHashMap.hpp>
+#include <PerfectHashMap.hpp>
+#include <PrefixMap.hpp>
+#include <SortedMap.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 using namespace ctm;
 
@@ -45,7 +64,10 @@ constexpr auto makeTestMap0010() {
 void test0010() {
     constexpr auto map = makeTestMap0010();
 
-    static_assert(sizeof(map) == 10 * sizeof(std::tuple<String, void*>),
+    static_assert(sizeof(map)
+                      == sizeof(std::size_t)
+                             + 9 * (sizeof(std::size_t)
+                                    + sizeof(std::tuple<String, void*>)),
                   "Invalid sizeof");
 
     static_assert(std::is_same<decltype(map)::KeyType, String>::value,
@@ -56,10 +78,10 @@ void test0010() {
         std::is_same<decltype(map)::PairType, std::pair<String, int (*)()>>::value,
         "Invalid pair type");
     static_assert(map.bucketSize() == 1, "Invalid bucket size");
-    static_assert(map.bucketCount() == 10, "Invalid bucket count");
+    static_assert(map.bucketCount() == 9, "Invalid bucket count");
     static_assert(map.size() == 6, "Invalid size");
     assert(map.bucketSize() == 1);
-    assert(map.bucketCount() == 10);
+    assert(map.bucketCount() == 9);
     assert(map.size() == 6);
 
     static_assert(map["bsd"] == f1, "Invalid value");
@@ -117,7 +139,10 @@ constexpr auto makeTestMap0020() {
 void test0020() {
     constexpr auto map = makeTestMap0020();
 
-    static_assert(sizeof(map) == 5 * sizeof(std::tuple<String, void*, void*, void*>),
+    static_assert(sizeof(map)
+                      == sizeof(std::size_t)
+                             + 4 * (sizeof(std::size_t)
+                                    + sizeof(std::tuple<String, void*, void*, void*>)),
                   "Invalid sizeof");
 
     static_assert(std::is_same<decltype(map)::KeyType, String>::value,
@@ -133,10 +158,10 @@ void test0020() {
                       std::tuple<int (*)(int), int (*)(int), int (*)(int)>>>::value,
         "Invalid pair type");
     static_assert(map.bucketSize() == 1, "Invalid bucket size");
-    static_assert(map.bucketCount() == 5, "Invalid bucket count");
+    static_assert(map.bucketCount() == 4, "Invalid bucket count");
     static_assert(map.size() == 4, "Invalid size");
     assert(map.bucketSize() == 1);
-    assert(map.bucketCount() == 5);
+    assert(map.bucketCount() == 4);
     assert(map.size() == 4);
 
     static_assert(std::get<0>(map["Eeny"]) == fTest00201, "Invalid value");
@@ -203,11 +228,15 @@ constexpr auto makeTestMap0030() {
 void test0030() {
     constexpr auto map = makeTestMap0030();
 
-    static_assert(sizeof(map) == 6 * sizeof(std::tuple<String, char>), "Invalid sizeof");
-    static_assert(map.bucketSize() == 3, "Invalid bucket size");
+    static_assert(sizeof(map)
+                      == sizeof(std::size_t)
+                             + 4 * (sizeof(std::size_t)
+                                    + sizeof(std::tuple<String, char>)),
+                  "Invalid sizeof");
+    static_assert(map.bucketSize() == 2, "Invalid bucket size");
     static_assert(map.bucketCount() == 2, "Invalid bucket count");
     static_assert(map.size() == 4, "Invalid size");
-    assert(map.bucketSize() == 3);
+    assert(map.bucketSize() == 2);
     assert(map.bucketCount() == 2);
     assert(map.size() == 4);
 
@@ -239,7 +268,8 @@ constexpr auto makeTestMap0040() {
 
 void test0040() {
     constexpr auto map = makeTestMap0040();
-    static_assert(sizeof(map) == 5 * sizeof(std::tuple<int, int, char>),
+    static_assert(sizeof(map)
+                      == sizeof(std::size_t) + 5 * sizeof(std::tuple<int, int, char>) + 4,
                   "Invalid sizeof");
     static_assert(map.bucketSize() == 1, "Invalid bucket size");
     static_assert(map.bucketCount() == 5, "Invalid bucket count");
@@ -271,10 +301,1750 @@ void test0040() {
     assert(std::get<1>(map[0]) == '\0');
 }
 
+constexpr auto makeTestMap0050() {
+    constexpr auto spec = makePerfectHashMapSpec(std::make_tuple("bsd", f1),
+                                                 std::make_tuple("holy", f2),
+                                                 std::make_tuple("", f3),
+                                                 std::make_tuple("duplicate", f4),
+                                                 std::make_tuple(key4, f5),
+                                                 std::make_tuple("duplicate", fDuplicate),
+                                                 std::make_tuple("ab", f6));
+    return PerfectHashMap<decltype(spec),
+                          spec.displacementCount,
+                          spec.bucketCount,
+                          spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0051() {
+    constexpr auto spec = makePerfectHashMapSpec(2.0,
+                                                 std::make_tuple("GET", 1),
+                                                 std::make_tuple("HEAD", 2),
+                                                 std::make_tuple("POST", 3),
+                                                 std::make_tuple("PUT", 4),
+                                                 std::make_tuple("DELETE", 5),
+                                                 std::make_tuple("CONNECT", 6),
+                                                 std::make_tuple("OPTIONS", 7),
+                                                 std::make_tuple("TRACE", 8),
+                                                 std::make_tuple("PATCH", 9),
+                                                 std::make_tuple("PROPFIND", 10),
+                                                 std::make_tuple("PROPPATCH", 11),
+                                                 std::make_tuple("MKCOL", 12),
+                                                 std::make_tuple("COPY", 13),
+                                                 std::make_tuple("MOVE", 14),
+                                                 std::make_tuple("LOCK", 15),
+                                                 std::make_tuple("UNLOCK", 16));
+    return PerfectHashMap<decltype(spec),
+                          spec.displacementCount,
+                          spec.bucketCount,
+                          spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0052() {
+    constexpr auto spec = makePerfectHashMapSpec(std::make_tuple(4096, 1, 'q'),
+                                                 std::make_tuple(2048, 2, 'w'),
+                                                 std::make_tuple(8192, 3, 'e'),
+                                                 std::make_tuple(1024, 4, 'r'),
+                                                 std::make_tuple(0, 5, 't'));
+    static_assert(spec.maxBucketSize == 1, "Invalid bucket size");
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   PerfectStorage<spec.displacementCount>,
+                   KeyPrefilter>::make(spec);
+}
+
+constexpr auto makeTestMap0053() {
+    // A single displacement bucket rarely fits a minimal table, some slots stay empty.
+    constexpr auto spec = makePerfectHashMapSpec(100.0,
+                                                 std::make_tuple(146, 1),
+                                                 std::make_tuple(147, 2),
+                                                 std::make_tuple(148, 3),
+                                                 std::make_tuple(149, 4),
+                                                 std::make_tuple(150, 5),
+                                                 std::make_tuple(151, 6),
+                                                 std::make_tuple(152, 7),
+                                                 std::make_tuple(153, 8),
+                                                 std::make_tuple(154, 9),
+                                                 std::make_tuple(155, 10),
+                                                 std::make_tuple(156, 11),
+                                                 std::make_tuple(157, 12));
+    return PerfectHashMap<decltype(spec),
+                          spec.displacementCount,
+                          spec.bucketCount,
+                          spec.elementCount>::make(spec);
+}
+
+void test0050() {
+    constexpr auto map = makeTestMap0050();
+
+    static_assert(map.bucketSize() == 1, "Invalid bucket size");
+    static_assert(map.bucketCount() == 6, "Invalid bucket count");
+    static_assert(map.size() == 6, "Invalid size");
+    // The seed and 2 displacements, no fingerprints.
+    static_assert(sizeof(map)
+                      == 3 * sizeof(std::size_t) + 6 * sizeof(std::tuple<String, void*>),
+                  "Invalid sizeof");
+    static_assert(map.stats().maxHitProbeLength == 1, "Invalid probe length");
+    static_assert(map.stats().averageMissProbeLength == 1.0, "Invalid probe length");
+
+    static_assert(map["bsd"] == f1, "Invalid value");
+    static_assert(map["holy"] == f2, "Invalid value");
+    static_assert(map[""] == f3, "Invalid value");
+    static_assert(map["duplicate"] == f4, "Invalid value");
+    static_assert(map["ac"] == f5, "Invalid value");
+    static_assert(map["ab"] == f6, "Invalid value");
+    static_assert(map["unknown"] == nullptr, "Invalid value");
+    assert(map["bsd"] == f1);
+    assert(map["holy"] == f2);
+    assert(map[""] == f3);
+    assert(map["duplicate"] == f4);
+    assert(map["ac"] == f5);
+    assert(map["ab"] == f6);
+    assert(map["unknown"] == nullptr);
+    auto key = std::string("holy");
+    assert(map[key] == f2);
+    key = "moly";
+    assert(map[key] == nullptr);
+
+    constexpr auto methods = makeTestMap0051();
+    static_assert(methods.bucketCount() == methods.size(), "Invalid bucket count");
+    static_assert(sizeof(methods)
+                      == 9 * sizeof(std::size_t) + 16 * sizeof(std::tuple<String, int>),
+                  "Invalid sizeof");
+    static_assert(methods.size() == 16, "Invalid size");
+    static_assert(methods["GET"] == 1, "Invalid value");
+    static_assert(methods["PROPPATCH"] == 11, "Invalid value");
+    static_assert(methods["UNLOCK"] == 16, "Invalid value");
+    static_assert(methods["get"] == 0, "Invalid value");
+    char const* const names[] = {"GET",
+                                 "HEAD",
+                                 "POST",
+                                 "PUT",
+                                 "DELETE",
+                                 "CONNECT",
+                                 "OPTIONS",
+                                 "TRACE",
+                                 "PATCH",
+                                 "PROPFIND",
+                                 "PROPPATCH",
+                                 "MKCOL",
+                                 "COPY",
+                                 "MOVE",
+                                 "LOCK",
+                                 "UNLOCK"};
+    for (int i = 0; i < 16; ++i)
+        assert(methods[names[i]] == i + 1);
+    assert(methods["SEARCH"] == 0);
+
+    constexpr auto numbers = makeTestMap0052();
+    static_assert(numbers.bucketCount() == 5, "Invalid bucket count");
+    static_assert(std::get<1>(numbers[4096]) == 'q', "Invalid value");
+    static_assert(std::get<1>(numbers[1024]) == 'r', "Invalid value");
+    static_assert(std::get<1>(numbers[0]) == 't', "Invalid value");
+    static_assert(std::get<1>(numbers[1]) == '\0', "Invalid value");
+    assert(std::get<0>(numbers[8192]) == 3);
+    assert(std::get<0>(numbers[0]) == 5);
+    assert(std::get<0>(numbers[3]) == 0);
+    // The prefilter rules out keys above the largest one before they are hashed.
+    static_assert(!numbers.mayContain(8193), "Invalid filter");
+    int const number_keys[] = {4096, 3, 0, 8193};
+    decltype(numbers)::ValueType number_values[4] = {};
+    numbers.findBatch(number_keys, 4, number_values);
+    assert(std::get<1>(number_values[0]) == 'q');
+    assert(std::get<1>(number_values[1]) == '\0');
+    assert(std::get<1>(number_values[2]) == 't');
+    assert(std::get<1>(number_values[3]) == '\0');
+
+    // Empty slots hold the default key, which is not in the map.
+    constexpr auto sparse = makeTestMap0053();
+    static_assert(sparse.bucketCount() > sparse.size(), "Invalid bucket count");
+    static_assert(!sparse.contains(0), "Invalid value");
+    static_assert(sparse[157] == 12, "Invalid value");
+    for (int i = 0; i < 146; ++i)
+        assert(!sparse.contains(i));
+    for (int i = 146; i < 158; ++i)
+        assert(sparse.at(i) == i - 145);
+}
+
+template <typename TReduction>
+constexpr auto makeTestMap0060() {
+    constexpr auto spec = makeHashMapSpec<TReduction>(std::make_tuple("bsd", f1),
+                                                      std::make_tuple("holy", f2),
+                                                      std::make_tuple("", f3),
+                                                      std::make_tuple("duplicate", f4),
+                                                      std::make_tuple(key4, f5),
+                                                      std::make_tuple("ab", f6));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+template <typename TReduction>
+constexpr auto makeTestMap0061() {
+    constexpr auto spec = makeHashMapSpec<TReduction>(1.0,
+                                                      0.25,
+                                                      std::make_tuple(4096, 'q'),
+                                                      std::make_tuple(2048, 'w'),
+                                                      std::make_tuple(8192, 'e'),
+                                                      std::make_tuple(1024, 'r'),
+                                                      std::make_tuple(3, 't'));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+void test0060() {
+    static_assert(MaskReduction::bucketCount(5) == 8, "Invalid bucket count");
+    static_assert(MaskReduction::bucketCount(8) == 8, "Invalid bucket count");
+    static_assert(MaskReduction::nextBucketCount(8) == 16, "Invalid bucket count");
+    static_assert(MaskReduction::reduce(13, 8) == 5, "Invalid reduction");
+    static_assert(ModuloReduction::bucketCount(0) == 1, "Invalid bucket count");
+    static_assert(FastRangeReduction::reduce(0, 7) == 0, "Invalid reduction");
+    static_assert(FastRangeReduction::reduce(static_cast<std::size_t>(-1), 7) < 7,
+                  "Invalid reduction");
+
+    constexpr auto mask_map = makeTestMap0060<MaskReduction>();
+    static_assert(std::is_same<decltype(mask_map)::KeyType, String>::value,
+                  "Invalid key type");
+    static_assert(mask_map.bucketCount() == 8, "Invalid bucket count");
+    static_assert(mask_map.size() == 6, "Invalid size");
+    static_assert(mask_map["bsd"] == f1, "Invalid value");
+    static_assert(mask_map["holy"] == f2, "Invalid value");
+    static_assert(mask_map[""] == f3, "Invalid value");
+    static_assert(mask_map["duplicate"] == f4, "Invalid value");
+    static_assert(mask_map["ac"] == f5, "Invalid value");
+    static_assert(mask_map["ab"] == f6, "Invalid value");
+    static_assert(mask_map["unknown"] == nullptr, "Invalid value");
+    assert(mask_map["holy"] == f2);
+    assert(mask_map[std::string("ab")] == f6);
+    assert(mask_map["unknown"] == nullptr);
+
+    constexpr auto range_map = makeTestMap0060<FastRangeReduction>();
+    static_assert(range_map.size() == 6, "Invalid size");
+    static_assert(range_map["bsd"] == f1, "Invalid value");
+    static_assert(range_map["holy"] == f2, "Invalid value");
+    static_assert(range_map[""] == f3, "Invalid value");
+    static_assert(range_map["duplicate"] == f4, "Invalid value");
+    static_assert(range_map["ac"] == f5, "Invalid value");
+    static_assert(range_map["ab"] == f6, "Invalid value");
+    static_assert(range_map["unknown"] == nullptr, "Invalid value");
+    assert(range_map["duplicate"] == f4);
+    assert(range_map[std::string("")] == f3);
+    assert(range_map["unknown"] == nullptr);
+
+    // Identity hashes of powers of two share all low bits, only a seed lets a mask split
+    // them.
+    constexpr auto mask_numbers = makeTestMap0061<MaskReduction>();
+    static_assert(mask_numbers.bucketCount() == 8, "Invalid bucket count");
+    static_assert(mask_numbers.bucketSize() == 1, "Invalid bucket size");
+    static_assert(mask_numbers[8192] == 'e', "Invalid value");
+    static_assert(mask_numbers[3] == 't', "Invalid value");
+    static_assert(mask_numbers[5] == '\0', "Invalid value");
+    assert(mask_numbers[1024] == 'r');
+
+    constexpr auto range_numbers = makeTestMap0061<FastRangeReduction>();
+    static_assert(range_numbers.bucketSize() == 1, "Invalid bucket size");
+    static_assert(range_numbers[4096] == 'q', "Invalid value");
+    static_assert(range_numbers[2048] == 'w', "Invalid value");
+    static_assert(range_numbers[5] == '\0', "Invalid value");
+    assert(range_numbers[1024] == 'r');
+    assert(range_numbers[3] == 't');
+}
+
+constexpr std::size_t testKeyCount0070 = 10000;
+
+constexpr unsigned makeTestKey0070(std::size_t index) {
+    auto key = static_cast<unsigned>(index * 2654435761u + 12345u);
+    key ^= key >> 15;
+    key *= 0x2c1b3c6du;
+    key ^= key >> 12;
+    return key;
+}
+
+template <std::size_t... I>
+constexpr auto makeTestSpec0070(std::index_sequence<I...>) {
+    return makeHashMapSpec(std::make_tuple(makeTestKey0070(I), static_cast<int>(I))...);
+}
+
+constexpr auto makeTestMap0070() {
+    constexpr auto spec = makeTestSpec0070(std::make_index_sequence<testKeyCount0070>());
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+void test0070() {
+    // Builds within the default constant evaluation limits of the compiler.
+    static constexpr auto map = makeTestMap0070();
+
+    static_assert(map.size() == testKeyCount0070, "Invalid size");
+    static_assert(map.bucketSize() == 4, "Invalid bucket size");
+    static_assert(map.bucketCount() == 18580, "Invalid bucket count");
+    static_assert(map[makeTestKey0070(0)] == 0, "Invalid value");
+    static_assert(map[makeTestKey0070(4321)] == 4321, "Invalid value");
+    static_assert(map[makeTestKey0070(testKeyCount0070 - 1)] == testKeyCount0070 - 1,
+                  "Invalid value");
+    for (std::size_t i = 0; i < testKeyCount0070; ++i)
+        assert(map[makeTestKey0070(i)] == static_cast<int>(i));
+    assert(map[makeTestKey0070(testKeyCount0070)] == 0);
+}
+
+struct CountingKey {
+    constexpr CountingKey() : value(0), comparisons(nullptr) {}
+
+    constexpr CountingKey(int value) : value(value), comparisons(nullptr) {}
+
+    CountingKey(int value, int* comparisons) : value(value), comparisons(comparisons) {}
+
+    constexpr bool operator==(CountingKey const& other) const {
+        if (other.comparisons)
+            ++*other.comparisons;
+        return value == other.value;
+    }
+
+    constexpr operator bool() const { return value != 0; }
+
+    int value;
+    int* comparisons;
+};
+
+namespace ctm {
+template <>
+struct Hash<CountingKey> {
+    constexpr std::size_t operator()(CountingKey const& key) const {
+        return static_cast<std::size_t>(key.value) << 1;
+    }
+};
+}
+
+constexpr auto makeTestMap0080() {
+    constexpr auto spec = makeHashMapSpec(4.0,
+                                          4.0,
+                                          std::make_tuple(CountingKey(2), 'a'),
+                                          std::make_tuple(CountingKey(4), 'b'),
+                                          std::make_tuple(CountingKey(6), 'c'),
+                                          std::make_tuple(CountingKey(1), 'd'));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+void test0080() {
+    constexpr auto map = makeTestMap0080();
+    static_assert(map.bucketCount() == 1, "Invalid bucket count");
+    static_assert(map.bucketSize() == 4, "Invalid bucket size");
+    static_assert(map[CountingKey(6)] == 'c', "Invalid value");
+    static_assert(map[CountingKey(1)] == 'd', "Invalid value");
+    static_assert(map[CountingKey(3)] == '\0', "Invalid value");
+
+    // All keys share the bucket, only the key with the matching hash is compared.
+    int comparisons = 0;
+    assert(map[CountingKey(6, &comparisons)] == 'c');
+    assert(comparisons == 1);
+    assert(map[CountingKey(1, &comparisons)] == 'd');
+    assert(comparisons == 2);
+    assert(map[CountingKey(3, &comparisons)] == '\0');
+    assert(comparisons == 2);
+
+    // String misses are rejected by the fingerprints alone.
+    constexpr auto strings = makeTestMap0030();
+    static_assert(strings["by the toe"] == 'b', "Invalid value");
+    static_assert(strings["by the toes"] == '\0', "Invalid value");
+    assert(strings[std::string("a tiger")] == 'a');
+    assert(strings[std::string("a lion")] == '\0');
+}
+
+constexpr auto makeTestMap0090() {
+    constexpr auto spec = makeHashMapSpec(1.0,
+                                          0.5,
+                                          std::make_tuple("bsd", f1),
+                                          std::make_tuple("holy", f2),
+                                          std::make_tuple("", f3),
+                                          std::make_tuple("duplicate", f4),
+                                          std::make_tuple(key4, f5),
+                                          std::make_tuple("duplicate", fDuplicate),
+                                          std::make_tuple("ab", f6));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   CompactStorage>::make(spec);
+}
+
+constexpr auto makeTestMap0091() {
+    constexpr auto spec = makeHashMapSpec(4.0,
+                                          2.0,
+                                          std::make_tuple(4096, 1, 'q'),
+                                          std::make_tuple(2048, 2, 'w'),
+                                          std::make_tuple(8192, 3, 'e'),
+                                          std::make_tuple(1024, 4, 'r'));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   CompactStorage>::make(spec);
+}
+
+void test0090() {
+    constexpr auto map = makeTestMap0090();
+
+    // The seed, 6 pairs with fingerprints, 10 one-byte offsets padded to the alignment.
+    static_assert(sizeof(map)
+                      == 3 * sizeof(std::size_t)
+                             + 6 * (sizeof(std::size_t)
+                                    + sizeof(std::tuple<String, void*>)),
+                  "Invalid sizeof");
+    static_assert(sizeof(map) < sizeof(makeTestMap0010()), "Invalid sizeof");
+    static_assert(map.bucketSize() == 1, "Invalid bucket size");
+    static_assert(map.bucketCount() == 9, "Invalid bucket count");
+    static_assert(map.size() == 6, "Invalid size");
+
+    static_assert(map["bsd"] == f1, "Invalid value");
+    static_assert(map["holy"] == f2, "Invalid value");
+    static_assert(map[""] == f3, "Invalid value");
+    static_assert(map["duplicate"] == f4, "Invalid value");
+    static_assert(map["ac"] == f5, "Invalid value");
+    static_assert(map["ab"] == f6, "Invalid value");
+    static_assert(map["unknown"] == nullptr, "Invalid value");
+    assert(map["bsd"] == f1);
+    assert(map[""] == f3);
+    assert(map["unknown"] == nullptr);
+    auto key = std::string("holy");
+    assert(map[key] == f2);
+    key = "moly";
+    assert(map[key] == nullptr);
+
+    std::size_t pair_count = 0;
+    for (auto const& pair : map) {
+        assert(pair.first);
+        if (pair.first == "ac")
+            assert(pair.first.chars() == key4);
+        ++pair_count;
+    }
+    assert(pair_count == 6);
+
+    constexpr auto numbers = makeTestMap0091();
+    static_assert(numbers.bucketCount() == 2, "Invalid bucket count");
+    static_assert(numbers.bucketSize() == 2, "Invalid bucket size");
+    // The seed, 3 one-byte offsets padded to the alignment, no fingerprints.
+    static_assert(sizeof(numbers)
+                      == 2 * sizeof(std::size_t) + 4 * sizeof(std::tuple<int, int, char>),
+                  "Invalid sizeof");
+    static_assert(std::get<0>(numbers[4096]) == 1, "Invalid value");
+    static_assert(std::get<1>(numbers[2048]) == 'w', "Invalid value");
+    static_assert(std::get<1>(numbers[8192]) == 'e', "Invalid value");
+    static_assert(std::get<0>(numbers[0]) == 0, "Invalid value");
+    assert(std::get<0>(numbers[1024]) == 4);
+    assert(std::get<1>(numbers[1]) == '\0');
+}
+
+void test0100() {
+    constexpr auto map = makeTestMap0010();
+    constexpr auto compact_map = makeTestMap0090();
+    constexpr auto perfect_map = makeTestMap0050();
+
+    static_assert(String("holy", 3) == String("hol"), "Invalid equality");
+    static_assert(!(String("holy", 3) == String("holy")), "Invalid equality");
+    static_assert(!(String("ab") == String("ac")), "Invalid equality");
+    static_assert(String("", 0) == String(""), "Invalid equality");
+
+    static_assert(map.find("bsdholy", 3) == f1, "Invalid value");
+    static_assert(map.find("bsdholy" + 3, 4) == f2, "Invalid value");
+    static_assert(map.find("bsdholy", 2) == nullptr, "Invalid value");
+    static_assert(map.find("bsdholy", 0) == f3, "Invalid value");
+    static_assert(compact_map.find("duplicates", 9) == f4, "Invalid value");
+    static_assert(perfect_map.find("bsdholy", 3) == f1, "Invalid value");
+
+    // Keys of a parsed buffer are neither terminated nor copied.
+    char const buffer[] = {'h', 'o', 'l', 'y', 'a', 'b', 'c'};
+    assert(map.find(buffer, 4) == f2);
+    assert(map.find(buffer + 4, 2) == f6);
+    assert(map.find(buffer + 4, 3) == nullptr);
+    assert(compact_map.find(buffer, 4) == f2);
+    assert(compact_map.find(buffer, 3) == nullptr);
+    assert(perfect_map.find(buffer + 4, 2) == f6);
+    assert(perfect_map.find(buffer + 4, 1) == nullptr);
+
+    char const* const pointer = "duplicate";
+    assert(map[pointer] == f4);
+    assert(map[std::string(pointer)] == f4);
+    assert(map[String(pointer, 3)] == nullptr);
+#if CTM_HAS_STRING_VIEW
+    static_assert(map[std::string_view("holyx", 4)] == f2, "Invalid value");
+    assert(compact_map[std::string_view(buffer, 4)] == f2);
+#endif
+}
+
+constexpr char metricNames[]
+    = "http.server.request.duration.seconds.bucket.le.0.005.total.count";
+
+template <std::size_t... I>
+constexpr auto makeWyHashes0110(std::index_sequence<I...>) {
+    return Array<std::size_t, sizeof...(I)>{{WyBytesHash<>::hash(metricNames, I)...}};
+}
+
+constexpr auto makeTestMap0110() {
+    constexpr auto spec = makeHashMapSpec<ModuloReduction, WyBytesHash<>>(
+        std::make_tuple("http.server.request.duration.seconds", 1),
+        std::make_tuple("http.server.request.body.size.bytes", 2),
+        std::make_tuple("http.client.request.duration.seconds", 3),
+        std::make_tuple("process.runtime.jvm.memory.usage.after.last.gc", 4),
+        std::make_tuple("x-request-id", 5),
+        std::make_tuple("content-type", 6),
+        std::make_tuple("", 7));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0111() {
+    constexpr auto spec = makePerfectHashMapSpec<WyBytesHash<>>(
+        std::make_tuple("x-request-id", 1),
+        std::make_tuple("content-type", 2),
+        std::make_tuple("content-length", 3),
+        std::make_tuple("accept-encoding", 4),
+        std::make_tuple("user-agent", 5));
+    return PerfectHashMap<decltype(spec),
+                          spec.displacementCount,
+                          spec.bucketCount,
+                          spec.elementCount>::make(spec);
+}
+
+void test0110() {
+    // Constant evaluation and unaligned run time loads agree for every length and tail.
+    constexpr auto hashes
+        = makeWyHashes0110(std::make_index_sequence<sizeof(metricNames)>());
+    std::string buffer(" ");
+    buffer += metricNames;
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        assert(WyBytesHash<>::hash(buffer.data() + 1, i) == hashes[i]);
+        for (std::size_t j = 0; j < i; ++j)
+            assert(hashes[i] != hashes[j]);
+    }
+    static_assert(WyBytesHash<>::hash("abc", 3) != WyBytesHash<>::hash("abc", 3, 1),
+                  "Invalid seed");
+
+    constexpr auto map = makeTestMap0110();
+    static_assert(map["http.server.request.duration.seconds"] == 1, "Invalid value");
+    static_assert(map["process.runtime.jvm.memory.usage.after.last.gc"] == 4,
+                  "Invalid value");
+    static_assert(map[""] == 7, "Invalid value");
+    static_assert(map["http.server.request.duration.second"] == 0, "Invalid value");
+    assert(map[std::string("http.server.request.body.size.bytes")] == 2);
+    assert(map[std::string("http.client.request.duration.seconds")] == 3);
+    assert(map[std::string("x-request-id")] == 5);
+    assert(map[std::string("content-type")] == 6);
+    assert(map[std::string("content-typo")] == 0);
+
+    constexpr auto perfect_map = makeTestMap0111();
+    static_assert(perfect_map["content-length"] == 3, "Invalid value");
+    assert(perfect_map[std::string("accept-encoding")] == 4);
+    assert(perfect_map[std::string("user-agent")] == 5);
+    assert(perfect_map[std::string("user-agents")] == 0);
+}
+
+void test0120() {
+    // Powers of two land in the same masked bucket, unless seeded.
+    constexpr auto spec = makeHashMapSpec<MaskReduction>(std::make_tuple(1024, 'a'),
+                                                         std::make_tuple(2048, 'b'),
+                                                         std::make_tuple(4096, 'c'),
+                                                         std::make_tuple(8192, 'd'),
+                                                         std::make_tuple(16384, 'e'),
+                                                         std::make_tuple(32768, 'f'),
+                                                         std::make_tuple(65536, 'g'),
+                                                         std::make_tuple(131072, 'h'));
+    static_assert(spec.seed != 0, "Invalid seed");
+    static_assert(spec.maxBucketSize == 1, "Invalid bucket size");
+    static_assert(spec.hashes[0] == Internal::seedHash(1024, spec.seed), "Invalid hash");
+
+    constexpr auto map = HashMap<decltype(spec),
+                                 spec.maxBucketSize,
+                                 spec.bucketCount,
+                                 spec.elementCount>::make(spec);
+    static_assert(map[1024] == 'a', "Invalid value");
+    static_assert(map[131072] == 'h', "Invalid value");
+    static_assert(map[512] == '\0', "Invalid value");
+    int keys[] = {1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072};
+    for (std::size_t i = 0; i < 8; ++i)
+        assert(map[keys[i]] == static_cast<char>('a' + i));
+    assert(map[0] == '\0');
+}
+
+enum class Opcode { nop, load, store, add, sub, mul, jump, halt };
+
+constexpr auto makeTestMap0130() {
+    constexpr auto spec = makeIntegerMapSpec(std::make_tuple(0x10, Opcode::nop),
+                                             std::make_tuple(0x11, Opcode::load),
+                                             std::make_tuple(0x12, Opcode::store),
+                                             std::make_tuple(0x14, Opcode::add),
+                                             std::make_tuple(0x15, Opcode::sub),
+                                             std::make_tuple(0x16, Opcode::mul),
+                                             std::make_tuple(0x11, Opcode::halt),
+                                             std::make_tuple(0x18, Opcode::jump),
+                                             std::make_tuple(0x1f, Opcode::halt));
+    return IntegerMap<decltype(spec),
+                      spec.isDense,
+                      spec.slotCount,
+                      spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0131() {
+    constexpr auto spec = makeIntegerMapSpec(std::make_tuple(-404, 1, 'n'),
+                                             std::make_tuple(4096, 2, 'q'),
+                                             std::make_tuple(2048, 3, 'w'),
+                                             std::make_tuple(8192, 4, 'e'),
+                                             std::make_tuple(1024, 5, 'r'),
+                                             std::make_tuple(65536, 6, 't'),
+                                             std::make_tuple(0, 7, 'z'));
+    return IntegerMap<decltype(spec),
+                      spec.isDense,
+                      spec.slotCount,
+                      spec.elementCount>::make(spec);
+}
+
+void test0130() {
+    constexpr auto opcodes = makeTestMap0130();
+    // Values and a bit per value, no keys.
+    static_assert(sizeof(opcodes) == 18 * sizeof(Opcode), "Invalid sizeof");
+    static_assert(opcodes.bucketCount() == 16, "Invalid bucket count");
+    static_assert(opcodes.size() == 8, "Invalid size");
+    static_assert(opcodes[0x10] == Opcode::nop, "Invalid value");
+    static_assert(opcodes[0x11] == Opcode::load, "Invalid value");
+    static_assert(opcodes[0x1f] == Opcode::halt, "Invalid value");
+    static_assert(opcodes[0x13] == Opcode::nop, "Invalid value");
+    static_assert(opcodes[0x20] == Opcode::nop, "Invalid value");
+    static_assert(opcodes[-1] == Opcode::nop, "Invalid value");
+    for (int code = 0; code < 0x40; ++code) {
+        auto const opcode = opcodes[code];
+        assert((code == 0x14) == (opcode == Opcode::add));
+        assert((code == 0x18) == (opcode == Opcode::jump));
+    }
+
+    constexpr auto numbers = makeTestMap0131();
+    static_assert(numbers.bucketCount() >= numbers.size(), "Invalid bucket count");
+    static_assert(numbers.bucketSize() == 1, "Invalid bucket size");
+    static_assert(numbers.size() == 7, "Invalid size");
+    static_assert(std::get<1>(numbers[-404]) == 'n', "Invalid value");
+    static_assert(std::get<0>(numbers[4096]) == 2, "Invalid value");
+    static_assert(std::get<0>(numbers[0]) == 7, "Invalid value");
+    static_assert(std::get<0>(numbers[4095]) == 0, "Invalid value");
+    assert(std::get<1>(numbers[65536]) == 't');
+    assert(std::get<1>(numbers[1024]) == 'r');
+    assert(std::get<0>(numbers[-1024]) == 0);
+    std::size_t pair_count = 0;
+    for (auto const& pair : numbers)
+        pair_count += std::get<0>(pair.second) != 0;
+    assert(pair_count == 7);
+
+    // The same keys are dense enough for a spread of 30000.
+    constexpr auto spec = makeIntegerMapSpec(30000.0,
+                                             std::make_tuple(-404, 1),
+                                             std::make_tuple(65536, 6),
+                                             std::make_tuple(0, 7));
+    static_assert(spec.isDense && spec.slotCount == 65941, "Invalid spec");
+}
+
+void test0140() {
+    constexpr auto map = makeTestMap0010();
+    constexpr auto compact_map = makeTestMap0090();
+    // More keys than in one batch, every batch mixes hits and misses.
+    std::string keys[40];
+    char const* const names[] = {"bsd", "holy", "", "duplicate", "ac", "ab", "moly", "a"};
+    for (std::size_t i = 0; i < 40; ++i)
+        keys[i] = names[i % 8];
+    int (*expected[])() = {f1, f2, f3, f4, f5, f6, nullptr, nullptr};
+
+    int (*values[40])() = {};
+    map.findBatch(keys, 40, values);
+    for (std::size_t i = 0; i < 40; ++i)
+        assert(values[i] == expected[i % 8]);
+
+    int (*compact_values[40])() = {};
+    compact_map.findBatch(names, 8, compact_values);
+    compact_map.findBatch(keys + 8, 32, compact_values + 8);
+    for (std::size_t i = 0; i < 40; ++i)
+        assert(compact_values[i] == expected[i % 8]);
+
+    constexpr auto numbers = makeTestMap0040();
+    int const number_keys[] = {4096, 2048, 8192, 1024, 0, 1};
+    decltype(numbers)::ValueType number_values[6];
+    numbers.findBatch(number_keys, 6, number_values);
+    assert(std::get<1>(number_values[0]) == 'q');
+    assert(std::get<1>(number_values[3]) == 'r');
+    assert(std::get<0>(number_values[4]) == 0);
+    assert(std::get<0>(number_values[5]) == 0);
+    numbers.findBatch(number_keys, 0, number_values);
+}
+
+constexpr auto makeTestMap0150() {
+    constexpr auto spec = makeKeyPositionMapSpec(std::make_tuple("GET", 1),
+                                                 std::make_tuple("HEAD", 2),
+                                                 std::make_tuple("POST", 3),
+                                                 std::make_tuple("PUT", 4),
+                                                 std::make_tuple("DELETE", 5),
+                                                 std::make_tuple("CONNECT", 6),
+                                                 std::make_tuple("OPTIONS", 7),
+                                                 std::make_tuple("TRACE", 8),
+                                                 std::make_tuple("PATCH", 9),
+                                                 std::make_tuple("PUT", 10));
+    return KeyPositionMap<decltype(spec),
+                          spec.positionCount,
+                          spec.displacementCount,
+                          spec.slotCount,
+                          spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0151() {
+    // Keys that differ only in their lengths or in their last characters.
+    constexpr auto spec = makeKeyPositionMapSpec(std::make_tuple("prefix", 'a'),
+                                                 std::make_tuple("prefix_", 'b'),
+                                                 std::make_tuple("prefix__", 'c'),
+                                                 std::make_tuple("prefix__0", 'd'),
+                                                 std::make_tuple("prefix__1", 'e'),
+                                                 std::make_tuple("", 'f'));
+    return KeyPositionMap<decltype(spec),
+                          spec.positionCount,
+                          spec.displacementCount,
+                          spec.slotCount,
+                          spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0152() {
+    constexpr auto spec = makeKeyPositionMapSpec(100.0,
+                                                 std::make_tuple("am", 1),
+                                                 std::make_tuple("bm", 2),
+                                                 std::make_tuple("cm", 3),
+                                                 std::make_tuple("dm", 4),
+                                                 std::make_tuple("em", 5),
+                                                 std::make_tuple("fm", 6),
+                                                 std::make_tuple("gm", 7),
+                                                 std::make_tuple("hm", 8),
+                                                 std::make_tuple("im", 9),
+                                                 std::make_tuple("jm", 10),
+                                                 std::make_tuple("km", 11),
+                                                 std::make_tuple("lm", 12));
+    return KeyPositionMap<decltype(spec),
+                          spec.positionCount,
+                          spec.displacementCount,
+                          spec.slotCount,
+                          spec.elementCount>::make(spec);
+}
+
+void test0150() {
+    constexpr auto methods = makeTestMap0150();
+    static_assert(methods.size() == 9, "Invalid size");
+    static_assert(methods.bucketCount() == 9, "Invalid bucket count");
+    static_assert(methods.positionCount() <= 2, "Invalid position count");
+    static_assert(methods["GET"] == 1, "Invalid value");
+    static_assert(methods["PUT"] == 4, "Invalid value");
+    static_assert(methods["CONNECT"] == 6, "Invalid value");
+    static_assert(methods["OPTIONS"] == 7, "Invalid value");
+    static_assert(methods["PATCH"] == 9, "Invalid value");
+    static_assert(methods["PATCHY"] == 0, "Invalid value");
+    static_assert(methods["GOT"] == 0, "Invalid value");
+    static_assert(methods[""] == 0, "Invalid value");
+    assert(methods[std::string("HEAD")] == 2);
+    assert(methods[std::string("DELETE")] == 5);
+    assert(methods[std::string("TRACE")] == 8);
+    assert(methods[std::string("POSH")] == 0);
+    assert(methods.find("POSTED", 4) == 3);
+
+    constexpr auto prefixes = makeTestMap0151();
+    static_assert(prefixes.positionCount() == 1, "Invalid position count");
+    static_assert(prefixes.position(0) == -1, "Invalid position");
+    static_assert(prefixes["prefix"] == 'a', "Invalid value");
+    static_assert(prefixes["prefix__"] == 'c', "Invalid value");
+    static_assert(prefixes["prefix__1"] == 'e', "Invalid value");
+    static_assert(prefixes[""] == 'f', "Invalid value");
+    assert(prefixes[std::string("prefix_")] == 'b');
+    assert(prefixes[std::string("prefix__0")] == 'd');
+    assert(prefixes[std::string("prefix__2")] == '\0');
+    assert(prefixes[std::string("Prefix")] == '\0');
+
+    // Empty slots hold the empty key, which is not in the map.
+    constexpr auto sparse = makeTestMap0152();
+    static_assert(sparse.bucketCount() > sparse.size(), "Invalid bucket count");
+    static_assert(!sparse.contains(""), "Invalid value");
+    static_assert(sparse["lm"] == 12, "Invalid value");
+    assert(!sparse.contains(std::string()));
+    assert(!sparse.contains("mm"));
+    assert(sparse.at(std::string("am")) == 1);
+}
+
+constexpr auto makeTestMap0160() {
+    constexpr auto spec = makeHashMapSpec(std::make_tuple("bsd", f1),
+                                          std::make_tuple("holy", f2),
+                                          std::make_tuple("", f3),
+                                          std::make_tuple("duplicate", f4),
+                                          std::make_tuple("ac", f5),
+                                          std::make_tuple("ab", f6));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   CompactStorage,
+                   KeyPrefilter>::make(spec);
+}
+
+constexpr auto makeTestMap0161() {
+    constexpr auto spec = makeHashMapSpec(std::make_tuple(-20, 'a'),
+                                          std::make_tuple(300, 'b'),
+                                          std::make_tuple(4096, 'c'));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   PaddedStorage,
+                   KeyPrefilter>::make(spec);
+}
+
+void test0160() {
+    constexpr auto map = makeTestMap0160();
+    // The filter takes a length bitmap and two character bitmaps.
+    static_assert(sizeof(map) == 9 * sizeof(std::uint64_t) + sizeof(makeTestMap0090()),
+                  "Invalid sizeof");
+
+    static_assert(map["bsd"] == f1, "Invalid value");
+    static_assert(map[""] == f3, "Invalid value");
+    static_assert(map["duplicate"] == f4, "Invalid value");
+    static_assert(map["ab"] == f6, "Invalid value");
+    static_assert(map["unknown"] == nullptr, "Invalid value");
+
+    static_assert(map.mayContain("bsd"), "Invalid filter");
+    static_assert(map.mayContain(""), "Invalid filter");
+    static_assert(map.mayContain("hold"), "Invalid filter");
+    // No keys of 5 characters, none starting with 'x', none ending with 'z'.
+    static_assert(!map.mayContain("holly"), "Invalid filter");
+    static_assert(!map.mayContain("xsd"), "Invalid filter");
+    static_assert(!map.mayContain("abz"), "Invalid filter");
+    static_assert(
+        !map.mayContain(String("a very long key that is longer than 63 characters, "
+                               "so it shares the last length bit")),
+                  "Invalid filter");
+    assert(map[std::string("holy")] == f2);
+    assert(map[std::string("holly")] == nullptr);
+    assert(map.find("acx", 2) == f5);
+    assert(!map.mayContain(std::string("ad ")));
+
+    std::string keys[] = {"bsd", "xyz", "", "hol", "ab"};
+    int (*values[5])() = {};
+    map.findBatch(keys, 5, values);
+    assert(values[0] == f1 && values[1] == nullptr && values[2] == f3);
+    assert(values[3] == nullptr && values[4] == f6);
+
+    constexpr auto numbers = makeTestMap0161();
+    static_assert(numbers[-20] == 'a', "Invalid value");
+    static_assert(numbers[4096] == 'c', "Invalid value");
+    static_assert(!numbers.mayContain(-21), "Invalid filter");
+    static_assert(!numbers.mayContain(4097), "Invalid filter");
+    static_assert(numbers.mayContain(0), "Invalid filter");
+    assert(numbers[300] == 'b');
+    assert(numbers[301] == '\0');
+}
+
+void test0170() {
+    std::vector<std::pair<std::string, int>> words
+        = {{"bsd", 1}, {"holy", 2}, {"", 3}, {"duplicate", 4}, {"duplicate", 999}};
+    auto map = FrozenHashMap<std::string, int>::make(words.begin(), words.end());
+    // The pairs do not have to outlive the map.
+    words.clear();
+    assert(map.size() == 4);
+    assert(map["bsd"] == 1);
+    assert(map[std::string("holy")] == 2);
+    assert(map[""] == 3);
+    assert(map["duplicate"] == 4);
+    assert(map["holly"] == 0);
+    assert(map.find("bsdx", 3) == 1);
+    std::size_t pair_count = 0;
+    for (auto const& pair : map)
+        pair_count += map[pair.first] == pair.second;
+    assert(pair_count == 4);
+
+    auto moved = std::move(map);
+    assert(moved["holy"] == 2);
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> numbers;
+    for (std::uint64_t i = 0; i < 20000; ++i)
+        numbers.emplace_back(i * 0x10001, i + 1);
+    using NumberMap = FrozenHashMap<std::uint64_t, std::uint64_t, MaskReduction>;
+    auto const serial = NumberMap::make(numbers.begin(), numbers.end());
+    auto const parallel = NumberMap::make(numbers.begin(), numbers.end(), 4);
+    // The number of threads does not change the result of the search.
+    assert(serial.bucketCount() == parallel.bucketCount());
+    assert(serial.bucketSize() == parallel.bucketSize());
+    assert(serial.seed() == parallel.seed());
+    for (std::uint64_t i = 0; i < 20000; ++i)
+        assert(parallel[i * 0x10001] == i + 1);
+    assert(parallel[std::uint64_t(1)] == 0);
+
+    auto const empty = FrozenHashMap<int, int>::make(numbers.end(), numbers.end());
+    assert(empty.size() == 0);
+    assert(empty[1] == 0);
+
+    // Pointer keys are compared by their characters, not by their addresses.
+    char first[] = "duplicate";
+    char second[] = "duplicate";
+    std::vector<std::pair<char const*, int>> pointers
+        = {{first, 1}, {second, 2}, {"bsd", 3}};
+    auto const strings
+        = FrozenHashMap<char const*, int>::make(pointers.begin(), pointers.end());
+    std::strcpy(first, "overwrite");
+    assert(strings.size() == 2);
+    char buffer[16] = {};
+    std::strcpy(buffer, "duplicate");
+    assert(strings[static_cast<char const*>(buffer)] == 1);
+    std::strcpy(buffer, "bsd");
+    assert(strings[static_cast<char const*>(buffer)] == 3);
+    assert(strings.find(buffer, 2) == 0);
+    assert(strings[static_cast<char const*>(first)] == 0);
+}
+
+void test0180() {
+    std::vector<std::pair<std::string, std::string>> words
+        = {{"bsd", "1"}, {"holy", "moly"}, {"", "empty"}, {"no value", ""}};
+    for (int i = 0; i < 1000; ++i)
+        words.emplace_back("key" + std::to_string(i), std::to_string(i * i));
+    auto const builder = FrozenImageBuilder<>::make(words.begin(), words.end());
+    std::ostringstream stream;
+    writeFrozenImage(stream, builder);
+    auto const image_string = stream.str();
+    // Images are read in place and must be aligned to 8 bytes.
+    std::vector<std::uint64_t> image((image_string.size() + 7) / 8);
+    std::memcpy(image.data(), image_string.data(), image_string.size());
+
+    auto const map = FrozenImageMap::fromImage(image.data(), image_string.size());
+    assert(map.size() == 1004);
+    assert(map.bucketCount() == builder.bucketCount());
+    assert(map["holy"] == "moly");
+    assert(map[""] == "empty");
+    assert(map["no value"] && map["no value"].empty());
+    assert(!map["unknown"]);
+    assert(map.find("bsdx", 3) == "1");
+    for (int i = 0; i < 1000; ++i)
+        assert(map["key" + std::to_string(i)] == String(std::to_string(i * i)));
+
+    bool is_rejected = false;
+    try {
+        FrozenImageMap::fromImage(image.data(), image_string.size() - 8);
+    } catch (std::runtime_error const&) {
+        is_rejected = true;
+    }
+    assert(is_rejected);
+
+    // Corrupt counts, bucket offsets and entries are rejected as well.
+    auto const is_corrupt = [&](std::size_t byte_offset, std::uint64_t value, int size) {
+        auto corrupt = image;
+        auto const bytes = reinterpret_cast<char*>(corrupt.data()) + byte_offset;
+        auto const word = static_cast<std::uint32_t>(value);
+        if (size == 8)
+            std::memcpy(bytes, &value, sizeof(value));
+        else
+            std::memcpy(bytes, &word, sizeof(word));
+        try {
+            FrozenImageMap::fromImage(corrupt.data(), image_string.size());
+        } catch (std::runtime_error const&) {
+            return true;
+        }
+        return false;
+    };
+    auto const offsets_offset = sizeof(FrozenImageHeader);
+    auto const entries_offset = (offsets_offset + (map.bucketCount() + 1) * 4 + 7) / 8 * 8
+                                + map.size() * sizeof(std::uint64_t);
+    auto const huge = ~std::uint64_t(0);
+    auto const entry = [&](std::size_t field) { return entries_offset + field; };
+    assert(is_corrupt(offsetof(FrozenImageHeader, bucketCount), huge, 8));
+    assert(is_corrupt(offsetof(FrozenImageHeader, elementCount), huge / 8, 8));
+    assert(is_corrupt(offsetof(FrozenImageHeader, elementCount), 1003, 8));
+    assert(is_corrupt(offsets_offset + map.bucketCount() * 4, 1003, 4));
+    assert(is_corrupt(offsets_offset + 4, 1005, 4));
+    assert(is_corrupt(entry(offsetof(FrozenImageEntry, keyOffset)), 1 << 30, 4));
+    assert(is_corrupt(entry(offsetof(FrozenImageEntry, valueSize)), 1 << 30, 4));
+    assert(!is_corrupt(offsetof(FrozenImageHeader, maxBucketSize), map.bucketSize(), 8));
+
+    char const path[] = "test0180.img";
+    std::ofstream(path, std::ios::binary) << image_string;
+    {
+        FrozenImageFile const file(path);
+        assert(file.map()["key999"] == "998001");
+        assert(!file.map()["key1000"]);
+    }
+    std::remove(path);
+
+    std::ostringstream header;
+    writeFrozenHeader(header, builder, "words");
+    assert(header.str().find("namespace words {") != std::string::npos);
+    assert(header.str().find("constexpr ctm::FrozenImageMap map{") != std::string::npos);
+}
+
+constexpr auto makeTestMap0190() {
+    constexpr auto data = makeHashMapSpec(std::make_tuple("Host", 1),
+                                          std::make_tuple("Accept", 2),
+                                          std::make_tuple("Content-Type", 3));
+    return HashMap<decltype(data),
+                   data.maxBucketSize,
+                   data.bucketCount,
+                   data.elementCount>::make(data);
+}
+
+constexpr auto makeTestMap0191() {
+    constexpr auto data
+        = makeHashMapSpec<MaskReduction>(std::make_tuple("Upgrade", 4),
+                                         std::make_tuple("Content-Type", 5));
+    return HashMap<decltype(data),
+                   data.maxBucketSize,
+                   data.bucketCount,
+                   data.elementCount,
+                   CompactStorage,
+                   KeyPrefilter>::make(data);
+}
+
+constexpr auto makeTestMap0192() {
+    constexpr auto data = makePerfectHashMapSpec(std::make_tuple("X-Vendor", 6),
+                                                 std::make_tuple("Content-Type", 7));
+    return PerfectHashMap<decltype(data),
+                          data.displacementCount,
+                          data.bucketCount,
+                          data.elementCount>::make(data);
+}
+
+void test0190() {
+    constexpr auto core = makeTestMap0190();
+    constexpr auto extension = makeTestMap0191();
+    constexpr auto vendor = makeTestMap0192();
+    static_assert(std::is_same<decltype(core)::HashedKeyType,
+                               decltype(vendor)::HashedKeyType>::value,
+                  "Invalid hashed key type");
+
+    // One hash serves all maps with the same key hash, whatever their seeds.
+    constexpr HashedKey<String> content_type("Content-Type");
+    static_assert(content_type.hash() == String("Content-Type").hash(), "Invalid hash");
+    static_assert(core.find(content_type) == 3, "Invalid value");
+    static_assert(extension.find(content_type) == 5, "Invalid value");
+    static_assert(vendor.find(content_type) == 7, "Invalid value");
+    constexpr HashedKey<String> upgrade("Upgrade");
+    static_assert(core.find(upgrade) == 0, "Invalid value");
+    static_assert(extension.find(upgrade) == 4, "Invalid value");
+
+    std::string const name = "X-Vendor";
+    HashedKey<String> const key(name);
+    assert(core.find(key) == 0 && extension.find(key) == 0 && vendor.find(key) == 6);
+    // The prefilter still rejects keys without looking at their hashes.
+    assert(extension.find(HashedKey<String>(String("Xpgrade"))) == 0);
+
+    std::vector<std::pair<std::string, int>> pairs = {{"Host", 8}, {"X-Vendor", 9}};
+    auto const frozen = FrozenHashMap<std::string, int>::make(pairs.begin(), pairs.end());
+    assert(frozen.find(key) == 9);
+    assert(frozen.find(content_type) == 0);
+
+    FrozenImageMap::HashedKeyType const image_key("Host");
+    std::vector<std::pair<std::string, std::string>> image_pairs = {{"Host", "8"}};
+    auto const builder
+        = FrozenImageBuilder<>::make(image_pairs.begin(), image_pairs.end());
+    std::ostringstream stream;
+    writeFrozenImage(stream, builder);
+    std::vector<std::uint64_t> image((stream.str().size() + 7) / 8);
+    std::memcpy(image.data(), stream.str().data(), stream.str().size());
+    auto const image_map = FrozenImageMap::fromImage(image.data(), stream.str().size());
+    assert(image_map.find(image_key) == String("8"));
+}
+
+constexpr auto makeTestMap0200() {
+    constexpr auto data = makeHashMapSpec(std::make_tuple("zero", 0),
+                                          std::make_tuple("one", 1),
+                                          std::make_tuple("two", 2));
+    return HashMap<decltype(data),
+                   data.maxBucketSize,
+                   data.bucketCount,
+                   data.elementCount,
+                   CompactStorage>::make(data);
+}
+
+constexpr auto makeTestMap0201() {
+    constexpr auto spec = makeIntegerMapSpec(std::make_tuple(0, 'a'),
+                                             std::make_tuple(1000, 'b'),
+                                             std::make_tuple(5000, '\0'));
+    return IntegerMap<decltype(spec),
+                      spec.isDense,
+                      spec.slotCount,
+                      spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0202() {
+    constexpr auto spec = makeIntegerMapSpec(std::make_tuple(7, 'a'),
+                                             std::make_tuple(1000, 'b'));
+    return IntegerMap<decltype(spec),
+                      spec.isDense,
+                      spec.slotCount,
+                      spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0203() {
+    constexpr auto spec = makeIntegerMapSpec(std::make_tuple(1, 'a'),
+                                             std::make_tuple(2, '\0'),
+                                             std::make_tuple(4, 'c'));
+    return IntegerMap<decltype(spec),
+                      spec.isDense,
+                      spec.slotCount,
+                      spec.elementCount>::make(spec);
+}
+
+void test0200() {
+    // Stored tuples are read in place.
+    static constexpr auto functions = makeTestMap0020();
+    static_assert(functions.findPtr("miny") == &functions.findPair("miny")->second,
+                  "Invalid pointer");
+    static_assert(std::get<2>(*functions.findPtr("miny")) == fTest00201, "Invalid value");
+    static_assert(functions.findPtr("unknown") == nullptr, "Invalid pointer");
+    static_assert(functions.findPair("moe")->first == "moe", "Invalid pair");
+    static_assert(std::get<1>(functions.at("moe")) == fTest00203, "Invalid value");
+
+    // A stored default value is not a miss.
+    constexpr auto numbers = makeTestMap0200();
+    static_assert(numbers.contains("zero") && numbers.at("zero") == 0, "Invalid value");
+    static_assert(!numbers.contains("three"), "Invalid value");
+    static_assert(*numbers.findPtr("two") == 2, "Invalid value");
+    assert(numbers.contains(std::string("one")));
+    assert(*numbers.findPtr(std::string("one")) == 1);
+    bool is_thrown = false;
+    try {
+        numbers.at("three");
+    } catch (std::out_of_range const&) {
+        is_thrown = true;
+    }
+    assert(is_thrown);
+
+    constexpr auto perfect = makeTestMap0050();
+    static_assert(perfect.contains("holy"), "Invalid value");
+    static_assert(!perfect.contains("holly"), "Invalid value");
+    static_assert(perfect.at("holy") == f2, "Invalid value");
+    constexpr auto keywords = makeTestMap0150();
+    static_assert(keywords.contains("POST") && !keywords.contains("PAST"),
+                  "Invalid value");
+
+    constexpr auto sparse_zero = makeTestMap0201();
+    constexpr auto sparse = makeTestMap0202();
+    constexpr auto dense = makeTestMap0203();
+    static_assert(dense.bucketCount() == 4, "Invalid bucket count");
+    static_assert(sparse_zero.contains(0) && sparse_zero.at(0) == 'a', "Invalid value");
+    static_assert(sparse_zero.contains(5000), "Invalid value");
+    static_assert(!sparse_zero.contains(1), "Invalid value");
+    static_assert(*sparse_zero.findPtr(1000) == 'b', "Invalid value");
+    // The zero key lands in the first slot, which the other keys leave empty.
+    static_assert(!sparse.contains(0) && sparse.contains(7), "Invalid value");
+    static_assert(dense.contains(2) && dense.at(2) == '\0', "Invalid value");
+    static_assert(!dense.contains(3) && !dense.contains(0), "Invalid value");
+    static_assert(!dense.contains(5) && dense.findPtr(3) == nullptr, "Invalid value");
+
+    std::vector<std::pair<std::string, int>> pairs = {{"zero", 0}};
+    auto const frozen = FrozenHashMap<std::string, int>::make(pairs.begin(), pairs.end());
+    assert(frozen.contains("zero") && !frozen.contains("one"));
+    assert(frozen.findPair("zero")->first == "zero" && frozen.at("zero") == 0);
+}
+
+constexpr auto makeTestSet0210() {
+    constexpr auto spec = makeHashSetSpec(
+        "break", "case", "continue", "default", "do", "else", "for", "goto", "if",
+        "return", "switch", "while");
+    return HashSet<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0210() {
+    constexpr auto spec = makeHashMapSpec(
+        std::make_tuple("break", true), std::make_tuple("case", true),
+        std::make_tuple("continue", true), std::make_tuple("default", true),
+        std::make_tuple("do", true), std::make_tuple("else", true),
+        std::make_tuple("for", true), std::make_tuple("goto", true),
+        std::make_tuple("if", true), std::make_tuple("return", true),
+        std::make_tuple("switch", true), std::make_tuple("while", true));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestSet0211() {
+    constexpr auto spec = makeHashSetSpec(1.0, 0.5, "GET", "HEAD", "POST", "PUT");
+    return HashSet<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   KeyPrefilter>::make(spec);
+}
+
+constexpr auto makeTestSet0212() {
+    constexpr auto spec = makeHashSetSpec(0, 7, 42, 1000);
+    return HashSet<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+void test0210() {
+    constexpr auto keywords = makeTestSet0210();
+    static_assert(keywords.size() == 12, "Invalid size");
+    static_assert(keywords.contains("while") && keywords.contains("do"), "Invalid value");
+    static_assert(!keywords.contains("whilst") && !keywords.contains(""),
+                  "Invalid value");
+    static_assert(keywords.contains("if (x)", 2), "Invalid value");
+    static_assert(keywords.contains(HashedKey<String>("goto")), "Invalid value");
+    // Twelve keys and their offsets against padded buckets of key and value pairs.
+    static_assert(sizeof(keywords) < sizeof(makeTestMap0210()) / 2, "Invalid size");
+    std::size_t count = 0;
+    for (auto const& key : keywords) {
+        assert(makeTestMap0210().find(key));
+        ++count;
+    }
+    assert(count == 12);
+    std::string const name = "switch";
+    assert(keywords.contains(name) && !keywords.contains(std::string("swatch")));
+
+    constexpr auto methods = makeTestSet0211();
+    static_assert(methods.contains("HEAD") && !methods.contains("HEAT"), "Invalid value");
+    static_assert(!methods.mayContain("DELETE"), "Invalid value");
+    assert(methods.contains(std::string("PUT")));
+
+    constexpr auto numbers = makeTestSet0212();
+    static_assert(numbers.contains(0) && numbers.contains(1000), "Invalid value");
+    static_assert(!numbers.contains(1) && !numbers.contains(-7), "Invalid value");
+}
+
+int fTest02201() { return 2201; }
+
+int fTest02202() { return 2202; }
+
+int fTest02203() { return 2203; }
+
+constexpr auto makeTestMap0220() {
+    constexpr auto spec = makeHashMapSpec(std::make_tuple("open", fTest02201),
+                                          std::make_tuple("close", f1),
+                                          std::make_tuple("open", fTest02202),
+                                          std::make_tuple("error", f2),
+                                          std::make_tuple("open", fTest02203),
+                                          std::make_tuple("close", f3));
+    return MultiHashMap<decltype(spec),
+                        spec.maxBucketSize,
+                        spec.bucketCount,
+                        spec.elementCount>::make(spec);
+}
+
+void test0220() {
+    constexpr auto handlers = makeTestMap0220();
+    static_assert(handlers.size() == 3 && handlers.valueCount() == 6, "Invalid size");
+    static_assert(handlers.count("open") == 3, "Invalid count");
+    static_assert(handlers.count("close") == 2, "Invalid count");
+    static_assert(handlers.count("error") == 1, "Invalid count");
+    static_assert(!handlers.contains("reset") && handlers.equal_range("reset").empty(),
+                  "Invalid count");
+    // Values keep the order of the spec.
+    static_assert(*handlers.equal_range("open").begin() == fTest02201, "Invalid value");
+    static_assert(handlers.equal_range("open").begin()[2] == fTest02203,
+                  "Invalid value");
+    static_assert(handlers.equal_range("close").begin()[1] == f3, "Invalid value");
+    static_assert(handlers.equal_range("error ", 5).size() == 1, "Invalid count");
+    static_assert(handlers.count(HashedKey<String>("close")) == 2, "Invalid count");
+
+    int sum = 0;
+    for (auto handler : handlers.equal_range(std::string("open")))
+        sum += handler();
+    assert(sum == 2201 + 2202 + 2203);
+    std::size_t value_count = 0;
+    for (auto const& key : handlers)
+        value_count += handlers.count(key);
+    assert(value_count == 6);
+
+    // Without repeated keys every range holds one value.
+    constexpr auto spec
+        = makeHashMapSpec(std::make_tuple(1, 'a'), std::make_tuple(2, 'b'));
+    constexpr auto chars = MultiHashMap<decltype(spec),
+                                        spec.maxBucketSize,
+                                        spec.bucketCount,
+                                        spec.elementCount>::make(spec);
+    static_assert(chars.count(1) == 1 && *chars.equal_range(2).begin() == 'b',
+                  "Invalid value");
+}
+
+constexpr auto makeTestMap0230() {
+    constexpr auto spec = makeSortedMapSpec(std::make_tuple(110, "1.1"),
+                                            std::make_tuple(100, "1.0"),
+                                            std::make_tuple(300, "3.0"),
+                                            std::make_tuple(200, "2.0"),
+                                            std::make_tuple(210, "2.1"),
+                                            std::make_tuple(200, "2.0 again"),
+                                            std::make_tuple(220, "2.2"));
+    return SortedMap<decltype(spec), spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0231() {
+    constexpr auto spec = makeSortedMapSpec(std::make_tuple("include", 1),
+                                            std::make_tuple("if", 2),
+                                            std::make_tuple("ifdef", 3),
+                                            std::make_tuple("ifndef", 4),
+                                            std::make_tuple("define", 5),
+                                            std::make_tuple("\xff", 6),
+                                            std::make_tuple("", 7));
+    return SortedMap<decltype(spec), spec.elementCount>::make(spec);
+}
+
+void test0230() {
+    constexpr auto versions = makeTestMap0230();
+    static_assert(versions.size() == 6, "Invalid size");
+    static_assert(versions.begin()->first == 100, "Invalid order");
+    static_assert(versions.lower_bound(200)->first == 200, "Invalid bound");
+    static_assert(versions.lower_bound(201)->first == 210, "Invalid bound");
+    static_assert(versions.lower_bound(0) == versions.begin(), "Invalid bound");
+    static_assert(versions.lower_bound(301) == versions.end(), "Invalid bound");
+    static_assert(versions.upper_bound(200)->first == 210, "Invalid bound");
+    static_assert(versions.upper_bound(300) == versions.end(), "Invalid bound");
+    static_assert(versions.equal_range(210).second - versions.equal_range(210).first == 1,
+                  "Invalid range");
+    static_assert(versions.equal_range(215).first == versions.equal_range(215).second,
+                  "Invalid range");
+    // A repeated key keeps its first value.
+    static_assert(String(versions[200]) == "2.0" && String(versions.at(220)) == "2.2",
+                  "Invalid value");
+    static_assert(!versions.contains(150) && versions.find(150) == nullptr,
+                  "Invalid value");
+
+    int previous = 0;
+    for (auto const& pair : versions) {
+        assert(previous < pair.first);
+        previous = pair.first;
+    }
+    std::vector<int> keys;
+    for (auto const& pair : versions)
+        keys.push_back(pair.first);
+    for (int key = 90; key <= 310; ++key) {
+        auto const bound = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+        assert(versions.lower_bound(key) - versions.begin() == bound);
+        auto const upper = std::upper_bound(keys.begin(), keys.end(), key) - keys.begin();
+        assert(versions.upper_bound(key) - versions.begin() == upper);
+    }
+
+    constexpr auto directives = makeTestMap0231();
+    static_assert(directives.begin()->first == "", "Invalid order");
+    static_assert((directives.end() - 1)->first == "\xff", "Invalid order");
+    static_assert(directives.prefixRange("if").first->second == 2, "Invalid range");
+    static_assert(directives.prefixRange("if").second->second == 1, "Invalid range");
+    static_assert(directives.prefixRange("ifn").second
+                      - directives.prefixRange("ifn").first
+                      == 1,
+                  "Invalid range");
+    static_assert(directives.prefixRange("").second == directives.end(), "Invalid range");
+    static_assert(directives.prefixRange("x").first == directives.prefixRange("x").second,
+                  "Invalid range");
+    auto const range = directives.prefixRange(std::string("i"));
+    assert(range.second - range.first == 4);
+    assert(directives.find(std::string("ifdef")) == 3 && !directives.contains("ifdeff"));
+}
+
+enum class Token { none, plus, increment, addAssign, minus, arrow, arrowStar, less, shift,
+                   shiftAssign, lessEqual, spaceship, kwIf, kwInt };
+
+template <std::size_t H = CTM_PREFIX_MAP_DENSE_NODE_COUNT>
+constexpr auto makeTestMap0240() {
+    constexpr auto spec = makePrefixMapSpec(std::make_tuple("+", Token::plus),
+                                            std::make_tuple("++", Token::increment),
+                                            std::make_tuple("+=", Token::addAssign),
+                                            std::make_tuple("-", Token::minus),
+                                            std::make_tuple("->", Token::arrow),
+                                            std::make_tuple("->*", Token::arrowStar),
+                                            std::make_tuple("<", Token::less),
+                                            std::make_tuple("<<", Token::shift),
+                                            std::make_tuple("<<=", Token::shiftAssign),
+                                            std::make_tuple("<=", Token::lessEqual),
+                                            std::make_tuple("<=>", Token::spaceship),
+                                            std::make_tuple("if", Token::kwIf),
+                                            std::make_tuple("int", Token::kwInt),
+                                            std::make_tuple("+", Token::none));
+    return PrefixMap<decltype(spec), spec.nodeCount, spec.elementCount, H>::make(spec);
+}
+
+// Tokens of a runtime buffer, the way a tokenizer loop finds them.
+template <typename TMap>
+std::vector<Token> tokenize0240(TMap const& tokens, std::string const& source) {
+    std::vector<Token> result;
+    for (auto ptr = source.data(), end = ptr + source.size(); ptr != end;) {
+        auto const pair = tokens.matchPrefix(ptr, end);
+        if (!pair) {
+            ++ptr;
+            continue;
+        }
+        result.push_back(pair->second);
+        ptr += pair->first.size();
+    }
+    return result;
+}
+
+void test0240() {
+    constexpr auto tokens = makeTestMap0240();
+    // The root, "+" with two children, "-" with "->" and "->*", "<" with "<<", "<<=",
+    // "<=" and "<=>", and "i" with "if", "in" and "int".
+    static_assert(tokens.size() == 13 && tokens.nodeCount() == 16, "Invalid size");
+    constexpr char input[] = "a<<=b->*c<=d<>e";
+    static_assert(tokens.matchPrefix(input, input + 15) == nullptr, "Invalid match");
+    static_assert(tokens.matchPrefix(input + 1, input + 15)->second == Token::shiftAssign,
+                  "Invalid match");
+    static_assert(tokens.matchPrefix(input + 1, input + 3)->second == Token::shift,
+                  "Invalid match");
+    static_assert(tokens.matchPrefix(input + 5, input + 15)->first.size() == 3,
+                  "Invalid match");
+    static_assert(tokens.matchPrefix(input + 9, input + 15)->second == Token::lessEqual,
+                  "Invalid match");
+    static_assert(tokens.matchPrefix(input + 12, input + 15)->second == Token::less,
+                  "Invalid match");
+    static_assert(tokens.matchPrefix(input + 15, input + 15) == nullptr, "Invalid match");
+    // A repeated key keeps its first value.
+    static_assert(tokens["+"] == Token::plus && tokens.at("int") == Token::kwInt,
+                  "Invalid value");
+    static_assert(!tokens.contains("in") && tokens.findPtr("i") == nullptr,
+                  "Invalid value");
+
+    std::string const source = "if(i<=n)i+=int->*x";
+    std::vector<Token> const expected = {Token::kwIf, Token::lessEqual, Token::addAssign,
+                                         Token::kwInt, Token::arrowStar};
+    assert(tokenize0240(tokens, source) == expected);
+    assert(tokens.find(std::string("<=>")) == Token::spaceship);
+
+    // Only the root is dense, the other nodes search their sorted children.
+    constexpr auto sparse_tokens = makeTestMap0240<1>();
+    static_assert(tokens.denseNodeCount() == 16 && sparse_tokens.denseNodeCount() == 1,
+                  "Invalid size");
+    static_assert(sparse_tokens.matchPrefix(input + 1, input + 15)->second
+                      == Token::shiftAssign,
+                  "Invalid match");
+    static_assert(sparse_tokens.matchPrefix(input + 12, input + 15)->second
+                      == Token::less,
+                  "Invalid match");
+    assert(tokenize0240(sparse_tokens, source) == expected);
+    for (auto const& pair : tokens)
+        assert(sparse_tokens.at(pair.first) == pair.second);
+    assert(!sparse_tokens.contains("<>") && !sparse_tokens.contains("in"));
+}
+
+constexpr auto makeTestScanner0250() {
+    constexpr auto spec = makePrefixMapSpec(std::make_tuple("he", 1),
+                                            std::make_tuple("she", 2),
+                                            std::make_tuple("his", 3),
+                                            std::make_tuple("hers", 4),
+                                            std::make_tuple("e", 5),
+                                            std::make_tuple("ushers", 6),
+                                            std::make_tuple("sh", 7),
+                                            std::make_tuple("", 8),
+                                            std::make_tuple("hishers", 9));
+    // Few dense states, so that the scans also leave them.
+    return KeyScanner<decltype(spec), spec.nodeCount, spec.elementCount, 4>::make(spec);
+}
+
+// Sums the values of the matches, so a scan can be checked in a constant expression.
+struct ScanSum {
+    constexpr void operator()(std::size_t offset, String const&, int value) {
+        sum += offset * 10 + static_cast<std::size_t>(value);
+    }
+
+    std::size_t sum;
+};
+
+constexpr std::size_t scanSum0250(char const* text, std::size_t size) {
+    ScanSum scan_sum{0};
+    makeTestScanner0250().scan(text, text + size, scan_sum);
+    return scan_sum.sum;
+}
+
+void test0250() {
+    constexpr auto scanner = makeTestScanner0250();
+    static_assert(scanner.size() == 9 && scanner.stateCount() == 21, "Invalid size");
+    static_assert(scanner.denseStateCount() == 4, "Invalid size");
+    // "sh" at 1, "she" at 1, "he" at 2, "e" at 3, "hers" at 2, "e" at 3.
+    static_assert(scanSum0250("ushers", 6)
+                      == (0 * 10 + 6) + (1 * 10 + 7) + (1 * 10 + 2) + (2 * 10 + 1)
+                             + (3 * 10 + 5) + (2 * 10 + 4),
+                  "Invalid matches");
+    static_assert(scanSum0250("xyz", 3) == 0, "Invalid matches");
+
+    std::vector<std::tuple<std::size_t, std::string, int>> matches;
+    std::string const text = "ushers his";
+    scanner.scan(text.data(),
+                 text.data() + text.size(),
+                 [&](std::size_t offset, String const& key, int value) {
+                     matches.emplace_back(offset, key.toStdString(), value);
+                 });
+    std::vector<std::tuple<std::size_t, std::string, int>> const expected = {
+        std::make_tuple(1, "sh", 7),     std::make_tuple(1, "she", 2),
+        std::make_tuple(2, "he", 1),     std::make_tuple(3, "e", 5),
+        std::make_tuple(0, "ushers", 6), std::make_tuple(2, "hers", 4),
+        std::make_tuple(7, "his", 3)};
+    assert(matches == expected);
+
+    // Every occurrence of every key, against a compare at every offset.
+    std::string random_text;
+    unsigned seed = 1;
+    for (std::size_t i = 0; i < 4096; ++i) {
+        seed = seed * 1103515245 + 12345;
+        random_text += "hesirux"[(seed >> 16) % 7];
+    }
+    std::size_t count = 0;
+    std::size_t offset_sum = 0;
+    scanner.scan(random_text.data(),
+                 random_text.data() + random_text.size(),
+                 [&](std::size_t offset, String const& key, int) {
+                     assert(random_text.compare(offset, key.size(), key.toStdString())
+                            == 0);
+                     ++count;
+                     offset_sum += offset;
+                 });
+    std::size_t expected_count = 0;
+    std::size_t expected_offset_sum = 0;
+    for (std::size_t offset = 0; offset < random_text.size(); ++offset) {
+        for (auto const& pair : scanner) {
+            auto const key = pair.first.toStdString();
+            if (!key.empty() && random_text.compare(offset, key.size(), key) == 0) {
+                ++expected_count;
+                expected_offset_sum += offset;
+            }
+        }
+    }
+    assert(count == expected_count && offset_sum == expected_offset_sum);
+}
+
+void test0260() {
+    static_assert(hashMapSpecWork(0) == 0, "Invalid work");
+    static_assert(hashMapSpecWork(8) < hashMapSpecWork(100), "Invalid work");
+    static_assert(hashMapSpecWork(100) < hashMapSpecWork(1000), "Invalid work");
+    // The searches of large maps try fewer bucket counts and seeds within their budgets.
+    static_assert(hashMapSpecWork(100000) < 10 * hashMapSpecWork(1000), "Invalid work");
+    static_assert(hashMapSpecWork<MaskReduction>(1000) < hashMapSpecWork(1000),
+                  "Invalid work");
+    // A header guards its spec with the estimate.
+    static_assert(hashMapSpecWork(16) < 1000000, "The keyword table is too large");
+}
+
+constexpr auto makeTestMap0270() {
+    constexpr auto spec = makeHashMapSpec(std::make_tuple("alpha", 1),
+                                          std::make_tuple("beta", 2),
+                                          std::make_tuple("gamma", 3),
+                                          std::make_tuple("delta", 4),
+                                          std::make_tuple("epsilon", 5),
+                                          std::make_tuple("zeta", 6),
+                                          std::make_tuple("eta", 7));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount>::make(spec);
+}
+
+constexpr auto makeTestMap0271() {
+    constexpr auto spec = makeHashMapSpec<MaskReduction>(2.0,
+                                                         1.0,
+                                                         std::make_tuple(10, 'a'),
+                                                         std::make_tuple(20, 'b'),
+                                                         std::make_tuple(30, 'c'),
+                                                         std::make_tuple(40, 'd'),
+                                                         std::make_tuple(50, 'e'));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   CompactStorage,
+                   KeyPrefilter>::make(spec);
+}
+
+template <typename TMap>
+void checkStats0270(TMap const& map) {
+    auto const stats = map.stats();
+    std::size_t bucket_count = 0;
+    std::size_t key_count = 0;
+    for (std::size_t i = 0; i < stats.occupancyHistogram.size(); ++i) {
+        bucket_count += stats.occupancyHistogram[i];
+        key_count += i * stats.occupancyHistogram[i];
+    }
+    assert(bucket_count == map.bucketCount());
+    assert(key_count == map.size());
+    assert(stats.emptyBucketCount == stats.occupancyHistogram[0]);
+    assert(stats.averageHitProbeLength >= 1.0);
+    assert(stats.averageHitProbeLength <= stats.maxHitProbeLength);
+    assert(stats.maxHitProbeLength <= map.bucketSize());
+    assert(stats.occupancyHistogram[stats.maxHitProbeLength] > 0);
+    assert(stats.byteCount == sizeof(map));
+    assert(stats.payloadByteCount == map.size() * sizeof(typename TMap::PairType));
+}
+
+void test0270() {
+    static constexpr auto words = makeTestMap0270();
+    constexpr auto word_stats = words.stats();
+    static_assert(word_stats.occupancyHistogram.size() == words.bucketSize() + 1,
+                  "Invalid histogram size");
+    static_assert(String(word_stats.reduction) == "modulo", "Invalid reduction");
+    checkStats0270(words);
+    assert(String(word_stats.bytesHash) == BytesHash::name());
+
+    static constexpr auto numbers = makeTestMap0271();
+    constexpr auto number_stats = numbers.stats();
+    static_assert(String(number_stats.reduction) == "mask", "Invalid reduction");
+    static_assert(number_stats.averageMissProbeLength * numbers.bucketCount()
+                    == numbers.size(),
+                  "Invalid miss probe length");
+    checkStats0270(numbers);
+
+    // Counted lookups, a key out of the range of the keys is not probed.
+    static LookupSite site(__FILE__, __LINE__);
+    auto const& map = numbers;
+    assert(map.find(30, site) == 'c');
+    assert(map.find(50, site) == 'e');
+    assert(map.find(35, site) == '\0');
+    assert(map.findPair(60, site) == nullptr);
+    using HashedKeyType = decltype(numbers)::HashedKeyType;
+    assert(map.findPair(HashedKeyType(10), site)->second == 'a');
+    assert(site.lookupCount() == 5);
+    assert(site.hitCount() == 3);
+    assert(site.missCount() == 2);
+    assert(site.probeCount() >= 3);
+    assert(site.probeCount() <= 4 * map.bucketSize());
+    bool is_listed = false;
+    for (auto ptr = LookupSite::first(); ptr; ptr = ptr->next())
+        is_listed = is_listed || (ptr == &site && ptr->line() > 0);
+    assert(is_listed);
+
+    // Without CTM_HASH_MAP_COUNTERS the macros are plain lookups.
+    static_assert(CTM_HASH_MAP_FIND(words, "gamma") == 3, "Invalid value");
+    static_assert(CTM_HASH_MAP_FIND_PAIR(words, "theta") == nullptr, "Invalid pair");
+}
+
+constexpr std::size_t testKeyCount0280 = 500;
+
+template <std::size_t... I>
+constexpr auto makeTestSpec0280(std::index_sequence<I...>) {
+    return makeGroupHashMapSpec(
+        std::make_tuple(makeTestKey0070(I), static_cast<int>(I))...);
+}
+
+constexpr auto makeTestMap0280() {
+    constexpr auto spec = makeTestSpec0280(std::make_index_sequence<testKeyCount0280>());
+    static_assert(spec.bucketCount == 42, "Invalid bucket count");
+    static_assert(spec.seed == 0, "Invalid seed");
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   GroupStorage>::make(spec);
+}
+
+constexpr auto makeTestMap0281() {
+    constexpr auto spec = makeHashMapSpec(std::make_tuple("alignas", 1),
+                                          std::make_tuple("auto", 2),
+                                          std::make_tuple("bool", 3),
+                                          std::make_tuple("break", 4),
+                                          std::make_tuple("case", 5),
+                                          std::make_tuple("catch", 6),
+                                          std::make_tuple("char", 7),
+                                          std::make_tuple("class", 8),
+                                          std::make_tuple("const", 9),
+                                          std::make_tuple("constexpr", 10),
+                                          std::make_tuple("continue", 11),
+                                          std::make_tuple("default", 12),
+                                          std::make_tuple("delete", 13),
+                                          std::make_tuple("double", 14),
+                                          std::make_tuple("else", 15),
+                                          std::make_tuple("enum", 16),
+                                          std::make_tuple("auto", 17));
+    return HashMap<decltype(spec),
+                   spec.maxBucketSize,
+                   spec.bucketCount,
+                   spec.elementCount,
+                   GroupStorage,
+                   KeyPrefilter>::make(spec);
+}
+
+void test0280() {
+    static constexpr auto integers = makeTestMap0280();
+    constexpr auto integer_stats = integers.stats();
+    // 500 keys in 42 groups of 16 slots at the default load of at most 75%.
+    static_assert(integer_stats.occupancyHistogram.size() == 17, "Invalid histogram");
+    static_assert(integers.bucketCount() == 42, "Invalid bucket count");
+    static_assert(integer_stats.averageHitProbeLength < 2.0, "Invalid probe length");
+    static_assert(integers[makeTestKey0070(0)] == 0, "Invalid value");
+    static_assert(integers[makeTestKey0070(123)] == 123, "Invalid value");
+    static_assert(integers[makeTestKey0070(testKeyCount0280)] == 0, "Invalid value");
+    std::size_t group_count = 0;
+    std::size_t key_count = 0;
+    for (std::size_t i = 0; i < integer_stats.occupancyHistogram.size(); ++i) {
+        group_count += integer_stats.occupancyHistogram[i];
+        key_count += i * integer_stats.occupancyHistogram[i];
+    }
+    assert(group_count == 42);
+    assert(key_count == testKeyCount0280);
+    assert(integer_stats.emptyBucketCount == 0);
+    assert(std::distance(integers.begin(), integers.end()) == 42 * 16);
+    for (std::size_t i = 0; i < testKeyCount0280; ++i) {
+        assert(integers[makeTestKey0070(i)] == static_cast<int>(i));
+        assert(!integers.contains(makeTestKey0070(testKeyCount0280 + i)));
+    }
+
+    // Every hit reads as many groups as the builder walked for its key.
+    static LookupSite site(__FILE__, __LINE__);
+    for (std::size_t i = 0; i < testKeyCount0280; ++i)
+        assert(integers.find(makeTestKey0070(i), site) == static_cast<int>(i));
+    assert(site.probeCount()
+           == static_cast<std::size_t>(integer_stats.averageHitProbeLength
+                                           * testKeyCount0280
+                                       + 0.5));
+    assert(integer_stats.maxHitProbeLength > 1);
+
+    static constexpr auto keywords = makeTestMap0281();
+    static_assert(keywords.size() == 16, "Invalid size");
+    // A searched spec gets as many groups, whatever its bucket count.
+    static_assert(keywords.bucketCount() == 2, "Invalid bucket count");
+    static_assert(keywords["auto"] == 2, "Invalid value");
+    static_assert(keywords["enum"] == 16, "Invalid value");
+    static_assert(keywords["explicit"] == 0, "Invalid value");
+    static_assert(keywords.stats().occupancyHistogram[16] == 0, "Invalid occupancy");
+    assert(keywords[std::string("constexpr")] == 10);
+    assert(keywords.find("classy", 5) == 8);
+    assert(keywords[std::string("")] == 0);
+    assert(keywords.at(String("default")) == 12);
+}
+
+// Counted lookups through the macros, in counters.cpp, which defines
+// CTM_HASH_MAP_COUNTERS.
+void test0290();
+
 int main() {
     test0010();
     test0020();
     test0030();
     test0040();
+    test0050();
+    test0060();
+    test0070();
+    test0080();
+    test0090();
+    test0100();
+    test0110();
+    test0120();
+    test0130();
+    test0140();
+    test0150();
+    test0160();
+    test0170();
+    test0180();
+    test0190();
+    test0200();
+    test0210();
+    test0220();
+    test0230();
+    test0240();
+    test0250();
+    test0260();
+    test0270();
+    test0280();
+    test0290();
     return 0;
 }
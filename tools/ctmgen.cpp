@@ -0,0 +1,79 @@
+// Builds a frozen map from a file of `key<TAB>value` lines and writes it as a C++ header
+// or as a binary image, see `FrozenImage.hpp`.  Lines without a tab map the whole line
+// to an empty value, repeated keys keep their first value.
+//
+//   ctmgen [--header NAME | --image] [--threads N] INPUT OUTPUT
+
+#include <FrozenImage.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+int usage() {
+    std::cerr << "usage: ctmgen [--header NAME | --image] [--threads N] INPUT OUTPUT\n";
+    return 2;
+}
+}
+
+int main(int argc, char** argv) {
+    std::string header_name;
+    std::size_t thread_count = std::thread::hardware_concurrency();
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string const arg = argv[i];
+        if (arg == "--header" && i + 1 < argc)
+            header_name = argv[++i];
+        else if (arg == "--image")
+            header_name.clear();
+        else if (arg == "--threads" && i + 1 < argc)
+            thread_count = std::strtoul(argv[++i], nullptr, 10);
+        else if (!arg.empty() && arg[0] == '-')
+            return usage();
+        else
+            paths.push_back(arg);
+    }
+    if (paths.size() != 2)
+        return usage();
+
+    std::ifstream input(paths[0]);
+    if (!input) {
+        std::cerr << "ctmgen: cannot read " << paths[0] << "\n";
+        return 1;
+    }
+    std::vector<std::pair<std::string, std::string>> pairs;
+    std::string line;
+    while (std::getline(input, line)) {
+        auto const tab = line.find('\t');
+        if (tab == std::string::npos)
+            pairs.emplace_back(line, std::string());
+        else
+            pairs.emplace_back(line.substr(0, tab), line.substr(tab + 1));
+    }
+
+    try {
+        auto const map = ctm::FrozenImageBuilder<>::make(pairs.begin(), pairs.end(),
+                                                          thread_count);
+        pairs.clear();
+        std::ofstream output(paths[1], std::ios::binary);
+        if (header_name.empty())
+            ctm::writeFrozenImage(output, map);
+        else
+            ctm::writeFrozenHeader(output, map, header_name);
+        if (!output.flush()) {
+            std::cerr << "ctmgen: cannot write " << paths[1] << "\n";
+            return 1;
+        }
+        std::cerr << "ctmgen: " << map.size() << " keys, " << map.bucketCount()
+                  << " buckets of at most " << map.bucketSize() << " keys\n";
+    } catch (std::exception const& e) {
+        std::cerr << "ctmgen: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}